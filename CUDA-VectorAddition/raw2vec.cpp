@@ -0,0 +1,33 @@
+/* Converts the lab's text .raw vectors into the binary .vec format from vecfile.h so they can be mmap'ed
+ * instead of parsed on every run. The text is parsed with all OpenMP threads.
+ *
+ * usage: raw2vec input.raw output.vec [alignment]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "vecfile.h"
+#include "../Common/Profiler.h"
+
+int main(int argc, char **argv) {
+  struct vecFile vf;
+  uint32_t alignment = VEC_DEFAULT_ALIGNMENT;
+
+  if (argc < 3)
+  { printf("usage: %s input.raw output.vec [alignment]\n", argv[0]); exit(EXIT_FAILURE); }
+  if (argc > 3) alignment = atoi(argv[3]);
+
+  ProfScope reading("Reading vector");
+  if (vecOpen(argv[1], &vf) != 0)
+  { printf("Cannot read %s.\n", argv[1]); exit(EXIT_FAILURE); }
+  printf("Reading %ld elements from %s: %f ms\n", vf.length, argv[1], reading.stop() * 1e3);
+
+  ProfScope writing("Writing vector");
+  if (vecWrite(argv[2], vf.data, vf.length, alignment) != 0)
+  { printf("Cannot write %s.\n", argv[2]); exit(EXIT_FAILURE); }
+  printf("Writing %s: %f ms\n", argv[2], writing.stop() * 1e3);
+
+  vecClose(&vf);
+  profFinish();
+  return 0;
+}
@@ -0,0 +1,4 @@
+#!
+g++ -O3 -march=native -fopenmp -pthread $1.cpp -o $1
+
+./$1
@@ -0,0 +1,164 @@
+/* Fused elementwise vector expressions for the vector add lab.
+ *
+ * input() wraps a float array, and arithmetic on the wrappers builds an expression tree at compile time
+ * instead of computing anything. evaluate() then runs the whole tree in one OpenMP parallel SIMD loop,
+ * so a chain of k operations over several inputs streams memory once with no temporary vectors:
+ *
+ *   evaluate(out, input(a) + input(b), n);                            // vecAdd
+ *   evaluate(y, alpha * input(x) + input(y), n);                      // axpy
+ *   evaluate(out, clamp(madd(input(a), 0.5f, input(b)), 0.0f, 1.0f), n); // scale-add-clamp
+ *   evaluate(out, madd(input(a), input(b), input(c)), n);             // fused multiply-add
+ *
+ * Every node is a small struct held by value (an array pointer or a constant for the leaves), so after
+ * inlining the loop body is the same code as writing the expression out by hand.
+ *
+ * For buffers allocated at VECEXPR_ALIGNMENT, alignedInput() and evaluateAligned() tell the compiler so
+ * and it can use aligned SIMD loads and stores with no peeling:
+ *
+ *   evaluateAligned(out, alignedInput(a) + alignedInput(b), n);
+ */
+
+#ifndef VECEXPR_H
+#define VECEXPR_H
+
+#include <math.h>
+#include <type_traits>
+#include <utility>
+
+#define VECEXPR_ALIGNMENT 64
+
+/* base of every expression node, E is the node type itself */
+template <class E>
+struct Expr {
+  const E &self() const { return static_cast<const E &>(*this); }
+};
+
+struct Input : Expr<Input> {
+  const float *data;
+  explicit Input(const float *d) : data(d) {}
+  float operator()(long i) const { return data[i]; }
+};
+
+/* an input the caller promises starts at a multiple of VECEXPR_ALIGNMENT bytes */
+struct AlignedInput : Expr<AlignedInput> {
+  const float *data;
+  explicit AlignedInput(const float *d) : data(d) {}
+  float operator()(long i) const {
+    return static_cast<const float *>(__builtin_assume_aligned(data, VECEXPR_ALIGNMENT))[i];
+  }
+};
+
+struct Scalar : Expr<Scalar> {
+  float value;
+  explicit Scalar(float v) : value(v) {}
+  float operator()(long) const { return value; }
+};
+
+template <class A, class Op>
+struct Unary : Expr<Unary<A, Op> > {
+  A a;
+  explicit Unary(const A &x) : a(x) {}
+  float operator()(long i) const { return Op::apply(a(i)); }
+};
+
+template <class A, class B, class Op>
+struct Binary : Expr<Binary<A, B, Op> > {
+  A a;
+  B b;
+  Binary(const A &x, const B &y) : a(x), b(y) {}
+  float operator()(long i) const { return Op::apply(a(i), b(i)); }
+};
+
+template <class A, class B, class C, class Op>
+struct Ternary : Expr<Ternary<A, B, C, Op> > {
+  A a;
+  B b;
+  C c;
+  Ternary(const A &x, const B &y, const C &z) : a(x), b(y), c(z) {}
+  float operator()(long i) const { return Op::apply(a(i), b(i), c(i)); }
+};
+
+// elementwise operations
+struct NegOp { static float apply(float a) { return -a; } };
+struct AbsOp { static float apply(float a) { return fabsf(a); } };
+struct AddOp { static float apply(float a, float b) { return a + b; } };
+struct SubOp { static float apply(float a, float b) { return a - b; } };
+struct MulOp { static float apply(float a, float b) { return a * b; } };
+struct DivOp { static float apply(float a, float b) { return a / b; } };
+struct MinOp { static float apply(float a, float b) { return a < b ? a : b; } };
+struct MaxOp { static float apply(float a, float b) { return a > b ? a : b; } };
+struct MaddOp { static float apply(float a, float b, float c) { return fmaf(a, b, c); } };
+struct ClampOp { static float apply(float x, float lo, float hi) { return x < lo ? lo : (x > hi ? hi : x); } };
+
+inline Input input(const float *data) { return Input(data); }
+inline AlignedInput alignedInput(const float *data) { return AlignedInput(data); }
+
+/* expressions pass through unchanged and plain numbers become constants, so they can be mixed freely */
+template <class E>
+const E &lift(const Expr<E> &e) { return e.self(); }
+inline Scalar lift(float v) { return Scalar(v); }
+
+template <class T>
+struct Lifted { typedef typename std::decay<decltype(lift(std::declval<const T &>()))>::type type; };
+
+// only enable the operators when at least one operand is an expression
+template <class A, class B>
+struct AnyExpr {
+  static const bool value = std::is_base_of<Expr<A>, A>::value || std::is_base_of<Expr<B>, B>::value;
+};
+
+#define VECEXPR_BINARY(name, op)                                                                     \
+  template <class A, class B, class = typename std::enable_if<AnyExpr<A, B>::value>::type>           \
+  Binary<typename Lifted<A>::type, typename Lifted<B>::type, op> name(const A &a, const B &b) {      \
+    return Binary<typename Lifted<A>::type, typename Lifted<B>::type, op>(lift(a), lift(b));         \
+  }
+
+VECEXPR_BINARY(operator+, AddOp)
+VECEXPR_BINARY(operator-, SubOp)
+VECEXPR_BINARY(operator*, MulOp)
+VECEXPR_BINARY(operator/, DivOp)
+VECEXPR_BINARY(vmin, MinOp)
+VECEXPR_BINARY(vmax, MaxOp)
+
+#undef VECEXPR_BINARY
+
+template <class A>
+Unary<A, NegOp> operator-(const Expr<A> &a) { return Unary<A, NegOp>(a.self()); }
+
+template <class A>
+Unary<A, AbsOp> vabs(const Expr<A> &a) { return Unary<A, AbsOp>(a.self()); }
+
+/* a * b + c with a single rounding */
+template <class A, class B, class C>
+Ternary<typename Lifted<A>::type, typename Lifted<B>::type, typename Lifted<C>::type, MaddOp>
+madd(const A &a, const B &b, const C &c) {
+  return Ternary<typename Lifted<A>::type, typename Lifted<B>::type, typename Lifted<C>::type, MaddOp>(
+    lift(a), lift(b), lift(c));
+}
+
+template <class A, class B, class C>
+Ternary<typename Lifted<A>::type, typename Lifted<B>::type, typename Lifted<C>::type, ClampOp>
+clamp(const A &x, const B &lo, const C &hi) {
+  return Ternary<typename Lifted<A>::type, typename Lifted<B>::type, typename Lifted<C>::type, ClampOp>(
+    lift(x), lift(lo), lift(hi));
+}
+
+/* compute out[i] = e(i) for every element in one parallel SIMD pass */
+template <class E>
+void evaluate(float *out, const Expr<E> &e, long len) {
+  const E expr = e.self();
+  #pragma omp parallel for simd schedule(static)
+  for (long i = 0; i < len; i++)
+    out[i] = expr(i);
+}
+
+/* evaluate() for an output that starts at a multiple of VECEXPR_ALIGNMENT bytes */
+template <class E>
+void evaluateAligned(float *out, const Expr<E> &e, long len) {
+  const E expr = e.self();
+  #pragma omp parallel for simd aligned(out : VECEXPR_ALIGNMENT) schedule(static)
+  for (long i = 0; i < len; i++)
+    out[i] = expr(i);
+}
+
+#endif
@@ -0,0 +1,231 @@
+/* Binary vector files for the vector add lab.
+ *
+ * A .vec file is a 64 byte header followed by the raw little endian elements:
+ *
+ *   offset  0  char[4]   magic "VECF"
+ *   offset  4  uint32    format version (1)
+ *   offset  8  uint32    element type (VEC_FLOAT32)
+ *   offset 12  uint32    alignment of the data in bytes
+ *   offset 16  uint64    number of elements
+ *   offset 24  uint64    byte offset of the first element, a multiple of the alignment
+ *   offset 32  padding up to the data offset
+ *
+ * With the default alignment of one page the data can be mmap'ed and used as an input buffer as is, so
+ * loading a vector costs no more than the page faults on first use. vecOpen also accepts the legacy text
+ * .raw files (element count followed by one float per line) and parses them with all OpenMP threads.
+ * vecReadHeader and vecWriteHeader let a program stream a binary file in chunks with pread/pwrite.
+ */
+
+#ifndef VECFILE_H
+#define VECFILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define VEC_MAGIC "VECF"
+#define VEC_VERSION 1
+#define VEC_FLOAT32 1
+#define VEC_DEFAULT_ALIGNMENT 4096
+
+struct vecHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t dtype;
+  uint32_t alignment;
+  uint64_t length;
+  uint64_t dataOffset;
+  char padding[32];
+};
+
+/* an open vector, data points into the mapping for binary files and into malloc'ed memory for text */
+struct vecFile {
+  const float *data;
+  long length;
+  void *map;
+  size_t mapLength;
+  float *parsed;
+  int binary;
+};
+
+/* check the header of a binary vector file, returns 0 if it holds float32 data that fits in the file */
+static inline int vecCheckHeader(const struct vecHeader *header, uint64_t fileSize) {
+  if (memcmp(header->magic, VEC_MAGIC, 4) != 0 || header->version != VEC_VERSION ||
+      header->dtype != VEC_FLOAT32 || header->alignment == 0 || header->dataOffset % header->alignment != 0 ||
+      header->dataOffset > fileSize)
+    return -1;
+  // compare element counts, a corrupt length times sizeof(float) could wrap around
+  if (header->length > (fileSize - header->dataOffset) / sizeof(float))
+    return -1;
+  return 0;
+}
+
+static inline void vecMakeHeader(struct vecHeader *header, long length, uint32_t alignment) {
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, VEC_MAGIC, 4);
+  header->version = VEC_VERSION;
+  header->dtype = VEC_FLOAT32;
+  header->alignment = alignment;
+  header->length = length;
+  header->dataOffset = alignment;
+}
+
+static inline int vecIsSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/* tokens that start inside [begin, end) belong to that chunk, so chunks never split a number */
+static inline long vecCountTokens(const char *text, size_t begin, size_t end) {
+  long count = 0;
+  for (size_t i = begin; i < end; i++)
+    if (!vecIsSpace(text[i]) && (i == 0 || vecIsSpace(text[i - 1])))
+      count++;
+  return count;
+}
+
+static inline void vecParseTokens(const char *text, size_t size, size_t begin, size_t end, float *out, long first, long length) {
+  char token[64];
+  long index = first;
+  for (size_t i = begin; i < end && index < length; i++) {
+    if (vecIsSpace(text[i]) || (i > 0 && !vecIsSpace(text[i - 1])))
+      continue;
+    // copy the token out because the mapping is not null terminated
+    size_t len = 0;
+    while (i + len < size && !vecIsSpace(text[i + len]) && len < sizeof(token) - 1) {
+      token[len] = text[i + len];
+      len++;
+    }
+    token[len] = '\0';
+    out[index++] = strtof(token, NULL);
+  }
+}
+
+/* parse a legacy text file in parallel: count the numbers in every chunk, then parse each chunk into place */
+static inline int vecParseText(const char *text, size_t size, struct vecFile *vf) {
+  size_t pos = 0;
+  while (pos < size && vecIsSpace(text[pos])) pos++;
+  long length = 0;
+  while (pos < size && text[pos] >= '0' && text[pos] <= '9')
+    length = length * 10 + (text[pos++] - '0');
+  if (pos == size && length == 0) return -1;
+
+  int chunks = 1;
+#ifdef _OPENMP
+  chunks = omp_get_max_threads();
+#endif
+  long *first = (long *)calloc(chunks + 1, sizeof(long));
+  size_t body = size - pos;
+
+  #pragma omp parallel for schedule(static)
+  for (int c = 0; c < chunks; c++)
+    first[c + 1] = vecCountTokens(text, pos + body * c / chunks, pos + body * (c + 1) / chunks);
+  for (int c = 0; c < chunks; c++)
+    first[c + 1] += first[c];
+  if (first[chunks] < length) {
+    free(first);
+    return -1;
+  }
+
+  float *data = NULL;
+  if (posix_memalign((void **)&data, 64, sizeof(float) * (length > 0 ? length : 1)) != 0) {
+    free(first);
+    return -1;
+  }
+  #pragma omp parallel for schedule(static)
+  for (int c = 0; c < chunks; c++)
+    vecParseTokens(text, size, pos + body * c / chunks, pos + body * (c + 1) / chunks, data, first[c], length);
+  free(first);
+
+  vf->data = data;
+  vf->parsed = data;
+  vf->length = length;
+  vf->binary = 0;
+  return 0;
+}
+
+/* open a binary or text vector file, returns 0 on success and -1 on failure */
+static inline int vecOpen(const char *path, struct vecFile *vf) {
+  memset(vf, 0, sizeof(*vf));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return -1;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return -1;
+  vf->map = map;
+  vf->mapLength = st.st_size;
+
+  const struct vecHeader *header = (const struct vecHeader *)map;
+  if ((size_t)st.st_size >= sizeof(struct vecHeader) && memcmp(header->magic, VEC_MAGIC, 4) == 0) {
+    if (vecCheckHeader(header, st.st_size) != 0) {
+      munmap(map, st.st_size);
+      vf->map = NULL;
+      return -1;
+    }
+    vf->data = (const float *)((const char *)map + header->dataOffset);
+    vf->length = (long)header->length;
+    vf->binary = 1;
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    return 0;
+  }
+
+  // legacy text file, the mapping is only needed while parsing
+  int result = vecParseText((const char *)map, st.st_size, vf);
+  munmap(map, st.st_size);
+  vf->map = NULL;
+  vf->mapLength = 0;
+  return result;
+}
+
+static inline void vecClose(struct vecFile *vf) {
+  if (vf->map) munmap(vf->map, vf->mapLength);
+  free(vf->parsed);
+  memset(vf, 0, sizeof(*vf));
+}
+
+/* read and check the header of a binary vector file opened with open(), returns 0 on success */
+static inline int vecReadHeader(int fd, struct vecHeader *header) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header))
+    return -1;
+  return vecCheckHeader(header, st.st_size);
+}
+
+/* write the header of a binary vector file opened with open(), the data then goes at header->dataOffset */
+static inline int vecWriteHeader(int fd, long length, uint32_t alignment, struct vecHeader *header) {
+  if (alignment < sizeof(struct vecHeader)) alignment = VEC_DEFAULT_ALIGNMENT;
+  vecMakeHeader(header, length, alignment);
+  if (pwrite(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header)) return -1;
+  return ftruncate(fd, header->dataOffset + length * sizeof(float));
+}
+
+/* write a binary vector file with the data starting at a multiple of alignment, returns 0 on success */
+static inline int vecWrite(const char *path, const float *data, long length, uint32_t alignment) {
+  if (alignment < sizeof(struct vecHeader)) alignment = VEC_DEFAULT_ALIGNMENT;
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) return -1;
+
+  struct vecHeader header;
+  vecMakeHeader(&header, length, alignment);
+
+  char *padding = (char *)calloc(alignment - sizeof(header), 1);
+  int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(padding, 1, alignment - sizeof(header), file) == alignment - sizeof(header) &&
+    fwrite(data, sizeof(float), length, file) == (size_t)length;
+  free(padding);
+  return fclose(file) == 0 && ok ? 0 : -1;
+}
+
+#endif
@@ -0,0 +1,158 @@
+/* Parallel reductions and prefix scans for the vector add lab.
+ *
+ * Every reduction splits the vector into fixed blocks of REDUCE_BLOCK elements that fit in L1. A block is
+ * summed into REDUCE_LANES independent double accumulators (one SIMD register's worth per pass), the
+ * lanes are combined in a fixed order, and the block results are added up in block order. The blocks and
+ * the order never depend on how many threads run them, so a sum gives bit for bit the same answer on 1
+ * thread or 64. Max reductions are exact and need no such care.
+ *
+ * The reductions take vecexpr.h expressions, so a dot product or a norm is computed straight from the
+ * inputs without a temporary vector, and evaluateMaxDiff computes an expression and its largest error
+ * against expected values in the same pass.
+ *
+ *   double s = vsum(x, n);
+ *   double d = vdot(x, y, n);
+ *   float err = evaluateMaxDiff(out, input(a) + input(b), expected, n);
+ *   inclusiveScan(x, prefix, n);
+ */
+
+#ifndef VECREDUCE_H
+#define VECREDUCE_H
+
+#include <math.h>
+#include <vector>
+#include "vecexpr.h"
+
+#define REDUCE_BLOCK 4096
+#define REDUCE_LANES 8
+
+/* sum of e(i) over [begin, end), always in the same order */
+template <class E>
+double blockSum(const E &expr, long begin, long end) {
+  double lanes[REDUCE_LANES] = { 0.0 };
+  long i = begin;
+  for (; i + REDUCE_LANES <= end; i += REDUCE_LANES) {
+    #pragma omp simd
+    for (int l = 0; l < REDUCE_LANES; l++)
+      lanes[l] += expr(i + l);
+  }
+  for (int l = 0; i < end; i++, l++)
+    lanes[l] += expr(i);
+  // pairwise combine so the order is fixed
+  for (int width = REDUCE_LANES / 2; width > 0; width /= 2)
+    for (int l = 0; l < width; l++)
+      lanes[l] += lanes[l + width];
+  return lanes[0];
+}
+
+/* deterministic parallel sum of an expression */
+template <class E>
+double reduceSum(const Expr<E> &e, long len) {
+  const E expr = e.self();
+  long blocks = (len + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+  std::vector<double> partial(blocks > 0 ? blocks : 1, 0.0);
+  #pragma omp parallel for schedule(static)
+  for (long b = 0; b < blocks; b++)
+    partial[b] = blockSum(expr, b * REDUCE_BLOCK, b * REDUCE_BLOCK + REDUCE_BLOCK < len ? b * REDUCE_BLOCK + REDUCE_BLOCK : len);
+  double total = 0.0;
+  for (long b = 0; b < blocks; b++)
+    total += partial[b];
+  return total;
+}
+
+/* largest e(i), or -INFINITY for an empty vector. Any NaN makes the result NaN: comparisons skip NaN,
+ * so NaNs are counted on the side rather than trusted to survive the max and the merge of the partials.
+ */
+template <class E>
+float reduceMax(const Expr<E> &e, long len) {
+  const E expr = e.self();
+  float best = -INFINITY;
+  long nans = 0;
+  #pragma omp parallel for simd reduction(max : best) reduction(+ : nans) schedule(static)
+  for (long i = 0; i < len; i++) {
+    float v = expr(i);
+    best = v > best ? v : best;
+    nans += v != v;
+  }
+  return nans > 0 ? NAN : best;
+}
+
+inline double vsum(const float *x, long len) { return reduceSum(input(x), len); }
+inline double vdot(const float *x, const float *y, long len) { return reduceSum(input(x) * input(y), len); }
+inline double vnorm1(const float *x, long len) { return reduceSum(vabs(input(x)), len); }
+inline double vnorm2(const float *x, long len) { return sqrt(reduceSum(input(x) * input(x), len)); }
+inline float vnormInf(const float *x, long len) { return len > 0 ? reduceMax(vabs(input(x)), len) : 0.0f; }
+
+inline float vmaxAbsDiff(const float *x, const float *y, long len) {
+  return len > 0 ? reduceMax(vabs(input(x) - input(y)), len) : 0.0f;
+}
+
+/* out[i] = e(i) and the largest |out[i] - expected[i]| in one pass, so checking a result costs no extra
+ * trip through memory. A NaN anywhere in the output or the expected values gives a NaN error.
+ */
+template <class E>
+float evaluateMaxDiff(float *out, const Expr<E> &e, const float *expected, long len) {
+  const E expr = e.self();
+  float error = 0.0f;
+  long nans = 0;
+  #pragma omp parallel for simd reduction(max : error) reduction(+ : nans) schedule(static)
+  for (long i = 0; i < len; i++) {
+    float v = expr(i);
+    out[i] = v;
+    float diff = fabsf(v - expected[i]);
+    error = diff > error ? diff : error;
+    nans += diff != diff;
+  }
+  return nans > 0 ? NAN : error;
+}
+
+/* evaluateMaxDiff() for an output and expected values that start at multiples of VECEXPR_ALIGNMENT bytes */
+template <class E>
+float evaluateMaxDiffAligned(float *out, const Expr<E> &e, const float *expected, long len) {
+  const E expr = e.self();
+  float error = 0.0f;
+  long nans = 0;
+  #pragma omp parallel for simd aligned(out, expected : VECEXPR_ALIGNMENT) reduction(max : error) \
+    reduction(+ : nans) schedule(static)
+  for (long i = 0; i < len; i++) {
+    float v = expr(i);
+    out[i] = v;
+    float diff = fabsf(v - expected[i]);
+    error = diff > error ? diff : error;
+    nans += diff != diff;
+  }
+  return nans > 0 ? NAN : error;
+}
+
+/* blocked scan: sum every block, prefix the block sums in order, then scan each block from its offset.
+ * Running sums are kept in double. exclusive shifts the result by one element and starts at 0.
+ */
+inline void blockedScan(const float *in, float *out, long len, bool exclusive) {
+  long blocks = (len + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+  std::vector<double> offsets(blocks + 1, 0.0);
+  #pragma omp parallel for schedule(static)
+  for (long b = 0; b < blocks; b++) {
+    long end = b * REDUCE_BLOCK + REDUCE_BLOCK < len ? b * REDUCE_BLOCK + REDUCE_BLOCK : len;
+    double sum = 0.0;
+    for (long i = b * REDUCE_BLOCK; i < end; i++)
+      sum += in[i];
+    offsets[b + 1] = sum;
+  }
+  for (long b = 0; b < blocks; b++)
+    offsets[b + 1] += offsets[b];
+  #pragma omp parallel for schedule(static)
+  for (long b = 0; b < blocks; b++) {
+    long end = b * REDUCE_BLOCK + REDUCE_BLOCK < len ? b * REDUCE_BLOCK + REDUCE_BLOCK : len;
+    double running = offsets[b];
+    for (long i = b * REDUCE_BLOCK; i < end; i++) {
+      double next = running + in[i];
+      out[i] = (float)(exclusive ? running : next);
+      running = next;
+    }
+  }
+}
+
+inline void inclusiveScan(const float *in, float *out, long len) { blockedScan(in, out, len, false); }
+inline void exclusiveScan(const float *in, float *out, long len) { blockedScan(in, out, len, true); }
+
+#endif
@@ -26,61 +26,78 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <cutil.h>
-
-__global__ void vecAdd(float *in1, float *in2, float *out, int len) {
-  //@@ Insert code to implement vector addition here
+#include <string.h>
+#include <math.h>
+#include "vecfile.h"
+#include "../Common/Profiler.h"
+
+/* vecAdd with the comparison against the expected output fused in. The largest error is kept as the bits
+ * of a non-negative float, which order the same as unsigned ints, so atomicMax can reduce it. A NaN has
+ * larger bits than any number and wins the max.
+ */
+__global__ void vecAddCheck(float *in1, float *in2, float *expected, float *out, int len, unsigned int *maxError) {
+  __shared__ unsigned int blockMax;
   int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (threadIdx.x == 0) blockMax = 0;
+  __syncthreads();
   if (i < len) {
-	out[i] = in1[i] + in2[i];
+	float sum = in1[i] + in2[i];
+	out[i] = sum;
+	atomicMax(&blockMax, __float_as_uint(fabsf(sum - expected[i])));
   }
-
+  // one global atomic per block
+  __syncthreads();
+  if (threadIdx.x == 0) atomicMax(maxError, blockMax);
 }
 
 int main(int argc, char **argv) {
   int inputLength1, inputLength2, outputLength;
-  float *hostInput1;
-  float *hostInput2;
+  const float *hostInput1;
+  const float *hostInput2;
   float *hostOutput;
   float *deviceInput1;
   float *deviceInput2;
   float *deviceOutput;
-  float *expectedOutput;
+  float *deviceExpected;
+  unsigned int *deviceMaxError;
+  unsigned int maxErrorBits;
+  float maxError;
+  const float *expectedOutput;
 
-  FILE *infile1, *infile2, *outfile;
-  unsigned int generic, gpu, copy, compute, blog = 1;
+  struct vecFile infile1, infile2, outfile;
+  unsigned int blog = 1;
 
   // Import host input data
-  CUT_SAFE_CALL(cutCreateTimer(&generic));
-  cutStartTimer(generic);
-  if ((infile1 = fopen("input0.raw", "r")) == NULL)
+  ProfScope importing("Importing data");
+  // text .raw and binary .vec files are both accepted, binary files are mmap'ed
+  if (vecOpen("input0.raw", &infile1) != 0)
   { printf("Cannot open input0.raw.\n"); exit(EXIT_FAILURE); }
-  if ((infile2 = fopen("input1.raw", "r")) == NULL)
+  if (vecOpen("input1.raw", &infile2) != 0)
   { printf("Cannot open input1.raw.\n"); exit(EXIT_FAILURE); }
-  fscanf(infile1, "%i", &inputLength1);
-  hostInput1 = (float*) malloc(sizeof(float) * inputLength1);
-  for (int i = 0; i < inputLength1; i++)
-    fscanf(infile1, "%f", &hostInput1[i]);
-  fscanf(infile2, "%i", &inputLength2);
-  hostInput2 = (float*) malloc(sizeof(float) * inputLength2);
-  for (int i = 0; i < inputLength2; i++)
-    fscanf(infile2, "%f", &hostInput2[i]);
-  fclose(infile1);
-  fclose(infile2);
+  inputLength1 = infile1.length;
+  hostInput1 = infile1.data;
+  inputLength2 = infile2.length;
+  hostInput2 = infile2.data;
+  // the expected output goes to the GPU with the inputs and is checked inside the kernel
+  if (vecOpen("output.raw", &outfile) != 0)
+  { printf("Cannot open output.raw.\n"); exit(EXIT_FAILURE); }
+  expectedOutput = outfile.data;
   hostOutput = (float *)malloc(sizeof(float) * inputLength1);
-  cutStopTimer(generic);
-  printf("Importing data and creating memory on host: %f ms\n", cutGetTimerValue(generic));
+  printf("Importing data and creating memory on host: %f ms\n", importing.stop() * 1e3);
 
   if (blog) printf("*** The input length is %i\n", inputLength1);
+  if (inputLength2 != inputLength1 || outfile.length != inputLength1)
+  { printf("Vector lengths differ: %i, %i and %li.\n", inputLength1, inputLength2, outfile.length); exit(EXIT_FAILURE); }
 
-  CUT_SAFE_CALL(cutCreateTimer(&gpu));
-  cutStartTimer(gpu);
+  ProfScope allocating("Allocating GPU memory");
   
   //@@ Allocate GPU memory here
   outputLength = inputLength1;
   cudaError_t err1 = cudaMalloc((void**) &deviceInput1, sizeof(float) * inputLength1);
   cudaError_t err2 = cudaMalloc((void**) &deviceInput2, sizeof(float) * inputLength2);
   cudaError_t err3 = cudaMalloc((void**) &deviceOutput, sizeof(float) * outputLength);
+  cudaError_t err4 = cudaMalloc((void**) &deviceExpected, sizeof(float) * outputLength);
+  cudaError_t err5 = cudaMalloc((void**) &deviceMaxError, sizeof(unsigned int));
   
   if (err1 != cudaSuccess) { 
 	printf("%s", cudaGetErrorString(err1)); 
@@ -94,20 +111,26 @@ int main(int argc, char **argv) {
 	printf("%s", cudaGetErrorString(err3)); 
 	exit(EXIT_FAILURE); 
   }
+  if (err4 != cudaSuccess) { 
+	printf("%s", cudaGetErrorString(err4)); 
+	exit(EXIT_FAILURE); 
+  }
+  if (err5 != cudaSuccess) { 
+	printf("%s", cudaGetErrorString(err5)); 
+	exit(EXIT_FAILURE); 
+  }
   
-  cutStopTimer(gpu);
-  printf("Allocating GPU memory: %f ms\n", cutGetTimerValue(gpu));
+  printf("Allocating GPU memory: %f ms\n", allocating.stop() * 1e3);
 
-  cutDeleteTimer(gpu);
-  CUT_SAFE_CALL(cutCreateTimer(&gpu));
-  cutStartTimer(gpu);
+  ProfScope copying("Copying input to GPU");
 
   //@@ Copy memory to the GPU here
   cudaMemcpy(deviceInput1, hostInput1, sizeof(float) * inputLength1, cudaMemcpyHostToDevice);
   cudaMemcpy(deviceInput2, hostInput2, sizeof(float) * inputLength2, cudaMemcpyHostToDevice);
+  cudaMemcpy(deviceExpected, expectedOutput, sizeof(float) * outputLength, cudaMemcpyHostToDevice);
+  cudaMemset(deviceMaxError, 0, sizeof(unsigned int));
   
-  cutStopTimer(gpu);
-  printf("Copying input memory to the GPU: %f ms\n", cutGetTimerValue(gpu));
+  printf("Copying input memory to the GPU: %f ms\n", copying.stop() * 1e3);
 
   //@@ Initialize the grid and block dimensions here
   dim3 gridDim((outputLength - 1) / 32 + 1, 1, 1);
@@ -116,60 +139,46 @@ int main(int argc, char **argv) {
   if (blog) printf("*** Block dimension is %i\n", blockDim.x);
   if (blog) printf("*** Grid dimension is %i\n", gridDim.x);
 
-  CUT_SAFE_CALL(cutCreateTimer(&compute));
-  cutStartTimer(compute);
+  ProfScope computing("CUDA computation");
   
   //@@ Launch the GPU Kernel here
-  vecAdd<<<gridDim, blockDim>>>(deviceInput1, deviceInput2, deviceOutput, outputLength);
+  vecAddCheck<<<gridDim, blockDim>>>(deviceInput1, deviceInput2, deviceExpected, deviceOutput, outputLength,
+    deviceMaxError);
   
   cudaDeviceSynchronize();
   
-  cutStopTimer(compute);
-  printf("Performing CUDA computation: %f ms\n", cutGetTimerValue(compute));
+  printf("Performing CUDA computation: %f ms\n", computing.stop() * 1e3);
 
-  CUT_SAFE_CALL(cutCreateTimer(&copy));
-  cutStartTimer(copy);
+  ProfScope copyingBack("Copying output to CPU");
 
   //@@ Copy the GPU memory back to the CPU here
   cudaMemcpy(hostOutput, deviceOutput, sizeof(float) * outputLength, cudaMemcpyDeviceToHost);
+  cudaMemcpy(&maxErrorBits, deviceMaxError, sizeof(unsigned int), cudaMemcpyDeviceToHost);
+  memcpy(&maxError, &maxErrorBits, sizeof(float));
   
-  cutStopTimer(copy);
-  printf("Copying output memory to the CPU: %f ms\n", cutGetTimerValue(copy));
+  printf("Copying output memory to the CPU: %f ms\n", copyingBack.stop() * 1e3);
 
-  cutDeleteTimer(gpu);
-  CUT_SAFE_CALL(cutCreateTimer(&gpu));
-  cutStartTimer(gpu);
+  ProfScope freeing("Freeing GPU memory");
   
   //@@ Free the GPU memory here
   cudaFree(deviceInput1);
   cudaFree(deviceInput2);
   cudaFree(deviceOutput);
+  cudaFree(deviceExpected);
+  cudaFree(deviceMaxError);
   
-  cutStopTimer(gpu);
-  printf("Freeing GPU Memory: %f ms\n", cutGetTimerValue(gpu));
+  printf("Freeing GPU Memory: %f ms\n", freeing.stop() * 1e3);
 
-  if ((outfile = fopen("output.raw", "r")) == NULL)
-  { printf("Cannot open output.raw.\n"); exit(EXIT_FAILURE); }
-  fscanf(outfile, "%i", &outputLength);
-  expectedOutput = (float*) malloc(sizeof(float) * outputLength);
-  for (int i = 0; i < outputLength; i++)
-    fscanf(outfile, "%f", &expectedOutput[i]);
-  fclose(outfile);
-  int test = 1;
-  for (int i = 0; i < outputLength; i++)
-    test = test && (abs(expectedOutput[i] - hostOutput[i]) < 0.005);
-  if (test) printf("Results correct.\n");
+  if (maxError < 0.005f) printf("Results correct.\n");
   else printf("Results incorrect.\n");
+  if (blog) printf("*** Largest error is %f\n", maxError);
 
-  cutDeleteTimer(generic);
-  cutDeleteTimer(gpu);
-  cutDeleteTimer(copy);
-  cutDeleteTimer(compute);
+  profFinish();
 
-  free(hostInput1);
-  free(hostInput2);
+  vecClose(&infile1);
+  vecClose(&infile2);
   free(hostOutput);
-  free(expectedOutput);
+  vecClose(&outfile);
   
   return 0;
 }
@@ -0,0 +1,402 @@
+/* Host backend for the CUDA vector add lab. Runs the same vecAdd operation with OpenMP threads and SIMD
+ * lanes instead of a GPU and reports the same phases as vectorAdd.cu so the timings can be put side by
+ * side. The "device" buffers are 64 byte aligned host buffers that are first touched by the threads that
+ * compute on them. vecAdd is the simplest instance of the fused expressions in vecexpr.h, and the
+ * expected output is loaded with the inputs and checked inside the same pass as a max error reduction
+ * (vecreduce.h) instead of in a second pass over the result.
+ *
+ * After the phases the kernel's effective bandwidth (three loads and one store per element) is compared
+ * with the STREAM add bandwidth of the machine, either measured at startup or given with -peak.
+ *
+ * The inputs and the expected output can be text .raw files or binary .vec files (see vecfile.h). Binary
+ * files whose data sits at the compute alignment in the mapping are read by the kernel in place, without a
+ * copy. Text files, and binary files written with an odd alignment, are copied into aligned buffers.
+ *
+ * With -chunk the vectors are never held in memory at once. Three threads form a pipeline that reads a
+ * chunk of both inputs and the expected output, computes and checks it, and writes it to -result, with
+ * -depth chunk buffers (triple buffering by default) moving between them so reading, computing and writing
+ * overlap. This mode needs binary .vec files and uses the same few megabytes of memory for any length.
+ *
+ * usage: vectorAddCPU [-threads n] [-reps n] [-stream elements] [-peak GB/s]
+ *                     [-in0 input0.raw] [-in1 input1.raw] [-out output.raw]
+ *                     [-chunk elements [-depth buffers] [-result result.vec]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "vecfile.h"
+#include "vecexpr.h"
+#include "vecreduce.h"
+#include "../Common/Profiler.h"
+
+// alignment of the compute buffers, one cache line and one AVX-512 register
+#define ALIGNMENT VECEXPR_ALIGNMENT
+
+/* vecAdd with the comparison against the expected output fused in, returns the largest error. Every
+ * buffer starts at ALIGNMENT, so the loop uses aligned SIMD loads and stores.
+ */
+float vecAddCheck(const float *in1, const float *in2, const float *expected, float *out, int len) {
+  return evaluateMaxDiffAligned(out, alignedInput(in1) + alignedInput(in2), expected, len);
+}
+
+float *alignedAlloc(size_t count) {
+  void *ptr = NULL;
+  if (posix_memalign(&ptr, ALIGNMENT, sizeof(float) * (count > 0 ? count : 1)) != 0)
+  { printf("Cannot allocate %zu floats.\n", count); exit(EXIT_FAILURE); }
+  return (float *)ptr;
+}
+
+/* copy with the same static schedule as vecAdd so every page is touched by the thread that uses it */
+void parallelCopy(float *dst, const float *src, int len) {
+  #pragma omp parallel for simd schedule(static)
+  for (int i = 0; i < len; i++)
+    dst[i] = src[i];
+}
+
+/* the compute buffer for an input: the mapping itself for an aligned binary file, otherwise an aligned copy
+ * first touched with the compute schedule. *owned says whether the buffer has to be freed.
+ */
+const float *computeBuffer(const struct vecFile *vf, int *owned) {
+  if (vf->binary && (uintptr_t)vf->data % ALIGNMENT == 0) {
+    *owned = 0;
+    return vf->data;
+  }
+  float *copy = alignedAlloc(vf->length);
+  parallelCopy(copy, vf->data, vf->length);
+  *owned = 1;
+  return copy;
+}
+
+/* best STREAM add bandwidth in GB/s over arrays far larger than the last level cache */
+double streamPeak(long n, int reps) {
+  float *a = alignedAlloc(n), *b = alignedAlloc(n), *c = alignedAlloc(n);
+  #pragma omp parallel for schedule(static)
+  for (long i = 0; i < n; i++) {
+    a[i] = 1.0f;
+    b[i] = 2.0f;
+    c[i] = 0.0f;
+  }
+  double best = 0.0;
+  for (int r = 0; r < reps; r++) {
+    ProfScope pass("STREAM add");
+    #pragma omp parallel for simd aligned(a, b, c : ALIGNMENT) schedule(static)
+    for (long i = 0; i < n; i++)
+      c[i] = a[i] + b[i];
+    double seconds = pass.stop();
+    double gbs = 3.0 * sizeof(float) * n / seconds / 1e9;
+    if (gbs > best) best = gbs;
+  }
+  free(a);
+  free(b);
+  free(c);
+  return best;
+}
+
+// pipeline stages in the order a chunk buffer goes through them, after writing it is read into again
+enum { STAGE_READ, STAGE_COMPUTE, STAGE_WRITE, STAGES };
+const char *stageNames[STAGES] = { "Reading chunks", "Computing and verifying chunks", "Writing chunks" };
+
+struct chunkSlot {
+  float *in1, *in2, *expected, *out;
+  long offset;
+  int count;
+  int stage;
+  int readFailed;
+};
+
+struct pipeline {
+  struct chunkSlot *slots;
+  int depth, chunk;
+  long length;
+  int fd1, fd2, fdExpected, fdResult;
+  off_t data1, data2, dataExpected, dataResult;
+  std::mutex lock;
+  std::condition_variable changed;
+  double busy[STAGES];
+  float maxError;
+  // set by both the read and the write thread
+  std::atomic<int> ioError;
+};
+
+/* pread until count bytes arrive, returns 0 on success */
+int readFull(int fd, void *buf, size_t count, off_t offset) {
+  while (count > 0) {
+    ssize_t got = pread(fd, buf, count, offset);
+    if (got <= 0) return -1;
+    buf = (char *)buf + got;
+    count -= got;
+    offset += got;
+  }
+  return 0;
+}
+
+int writeFull(int fd, const void *buf, size_t count, off_t offset) {
+  while (count > 0) {
+    ssize_t put = pwrite(fd, buf, count, offset);
+    if (put <= 0) return -1;
+    buf = (const char *)buf + put;
+    count -= put;
+    offset += put;
+  }
+  return 0;
+}
+
+/* one pipeline thread, it takes every chunk in order once the previous stage has handed its buffer over */
+void runStage(struct pipeline *p, int stage) {
+  long chunks = (p->length + p->chunk - 1) / p->chunk;
+  for (long c = 0; c < chunks; c++) {
+    struct chunkSlot *slot = &p->slots[c % p->depth];
+    {
+      std::unique_lock<std::mutex> guard(p->lock);
+      p->changed.wait(guard, [slot, stage] { return slot->stage == stage; });
+    }
+
+    ProfScope work(stageNames[stage]);
+    if (stage == STAGE_READ) {
+      slot->offset = c * p->chunk;
+      slot->count = (int)(p->length - slot->offset < p->chunk ? p->length - slot->offset : p->chunk);
+      size_t bytes = sizeof(float) * slot->count;
+      off_t at = sizeof(float) * slot->offset;
+      // the later stages skip a chunk that was not read completely instead of using stale buffers
+      slot->readFailed = readFull(p->fd1, slot->in1, bytes, p->data1 + at) != 0 ||
+          readFull(p->fd2, slot->in2, bytes, p->data2 + at) != 0 ||
+          readFull(p->fdExpected, slot->expected, bytes, p->dataExpected + at) != 0;
+      if (slot->readFailed) p->ioError = 1;
+      // the chunk is not needed again, keep the page cache from growing with the file
+      posix_fadvise(p->fd1, p->data1 + at, bytes, POSIX_FADV_DONTNEED);
+      posix_fadvise(p->fd2, p->data2 + at, bytes, POSIX_FADV_DONTNEED);
+      posix_fadvise(p->fdExpected, p->dataExpected + at, bytes, POSIX_FADV_DONTNEED);
+    }
+    else if (stage == STAGE_COMPUTE && !slot->readFailed) {
+      float error = vecAddCheck(slot->in1, slot->in2, slot->expected, slot->out, slot->count);
+      // a NaN error has to stick, later chunks compare false against it
+      if (error > p->maxError || error != error) p->maxError = error;
+    }
+    else if (stage == STAGE_WRITE && !slot->readFailed && p->fdResult >= 0) {
+      if (writeFull(p->fdResult, slot->out, sizeof(float) * slot->count,
+          p->dataResult + sizeof(float) * slot->offset) != 0)
+        p->ioError = 1;
+    }
+    p->busy[stage] += work.stop();
+
+    {
+      std::lock_guard<std::mutex> guard(p->lock);
+      slot->stage = (stage + 1) % STAGES;
+    }
+    p->changed.notify_all();
+  }
+}
+
+/* open a binary vector for streaming and return the offset of its data, exits on failure */
+int openStream(const char *path, off_t *data, long *length) {
+  struct vecHeader header;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0 || vecReadHeader(fd, &header) != 0)
+  { printf("Cannot stream %s, convert text files with raw2vec first.\n", path); exit(EXIT_FAILURE); }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  *data = header.dataOffset;
+  *length = header.length;
+  return fd;
+}
+
+/* out-of-core vector add, only depth chunks of each vector are in memory at any time */
+void streamAdd(const char *in0, const char *in1, const char *out, const char *result, int chunk, int depth) {
+  struct pipeline p;
+  long length1, length2, lengthExpected;
+  p.fd1 = openStream(in0, &p.data1, &length1);
+  p.fd2 = openStream(in1, &p.data2, &length2);
+  p.fdExpected = openStream(out, &p.dataExpected, &lengthExpected);
+  if (length1 != length2 || length1 != lengthExpected)
+  { printf("Vector lengths differ: %ld, %ld and %ld.\n", length1, length2, lengthExpected); exit(EXIT_FAILURE); }
+  printf("*** The input length is %ld\n", length1);
+  printf("*** Streaming %i element chunks through %i buffers\n", chunk, depth);
+
+  p.fdResult = -1;
+  if (result != NULL) {
+    struct vecHeader header;
+    p.fdResult = open(result, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (p.fdResult < 0 || vecWriteHeader(p.fdResult, length1, VEC_DEFAULT_ALIGNMENT, &header) != 0)
+    { printf("Cannot write %s.\n", result); exit(EXIT_FAILURE); }
+    p.dataResult = header.dataOffset;
+  }
+
+  p.depth = depth;
+  p.chunk = chunk;
+  p.length = length1;
+  p.maxError = 0.0f;
+  p.ioError = 0;
+  p.slots = (struct chunkSlot *)malloc(sizeof(struct chunkSlot) * depth);
+  for (int s = 0; s < depth; s++) {
+    p.slots[s].in1 = alignedAlloc(chunk);
+    p.slots[s].in2 = alignedAlloc(chunk);
+    p.slots[s].expected = alignedAlloc(chunk);
+    p.slots[s].out = alignedAlloc(chunk);
+    p.slots[s].stage = STAGE_READ;
+    p.slots[s].readFailed = 0;
+  }
+  for (int stage = 0; stage < STAGES; stage++)
+    p.busy[stage] = 0.0;
+
+  ProfScope streaming("Streaming pipeline");
+  std::thread workers[STAGES];
+  for (int stage = 0; stage < STAGES; stage++)
+    workers[stage] = std::thread(runStage, &p, stage);
+  for (int stage = 0; stage < STAGES; stage++)
+    workers[stage].join();
+  double elapsed = streaming.stop();
+
+  for (int stage = 0; stage < STAGES; stage++)
+    printf("%s: %f ms busy\n", stageNames[stage], p.busy[stage] * 1e3);
+  double bytes = sizeof(float) * (double)p.length * (p.fdResult >= 0 ? 4 : 3);
+  printf("Streaming pipeline: %f ms, %f GB/s of file data\n", elapsed * 1e3, bytes / elapsed / 1e9);
+  if (p.ioError) printf("Reading or writing a chunk failed.\n");
+  if (!p.ioError && p.maxError < 0.005f) printf("Results correct.\n");
+  else printf("Results incorrect.\n");
+  printf("*** Largest error is %f\n", p.maxError);
+
+  for (int s = 0; s < depth; s++) {
+    free(p.slots[s].in1);
+    free(p.slots[s].in2);
+    free(p.slots[s].expected);
+    free(p.slots[s].out);
+  }
+  free(p.slots);
+  close(p.fd1);
+  close(p.fd2);
+  close(p.fdExpected);
+  if (p.fdResult >= 0) close(p.fdResult);
+}
+
+int main(int argc, char **argv) {
+  int inputLength1, inputLength2, outputLength;
+  float *hostOutput;
+  const float *deviceInput1;
+  const float *deviceInput2;
+  float *deviceOutput;
+  const float *deviceExpected;
+  int ownInput1, ownInput2, ownExpected;
+
+  struct vecFile infile1, infile2, outfile;
+  const char *in0 = "input0.raw", *in1 = "input1.raw", *out = "output.raw", *result = NULL;
+  int chunk = 0, depth = 3;
+  double peak = 0.0;
+  int threads = omp_get_max_threads(), reps = 10, blog = 1;
+  long streamLength = 1L << 25;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-threads") == 0) threads = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "-reps") == 0) reps = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "-stream") == 0) streamLength = atol(argv[i + 1]);
+    else if (strcmp(argv[i], "-peak") == 0) peak = atof(argv[i + 1]);
+    else if (strcmp(argv[i], "-in0") == 0) in0 = argv[i + 1];
+    else if (strcmp(argv[i], "-in1") == 0) in1 = argv[i + 1];
+    else if (strcmp(argv[i], "-out") == 0) out = argv[i + 1];
+    else if (strcmp(argv[i], "-chunk") == 0) chunk = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "-depth") == 0) depth = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "-result") == 0) result = argv[i + 1];
+  }
+  if (threads < 1) threads = 1;
+  if (reps < 1) reps = 1;
+  omp_set_num_threads(threads);
+
+  if (chunk > 0) {
+    streamAdd(in0, in1, out, result, chunk, depth < 2 ? 2 : depth);
+    profFinish();
+    return 0;
+  }
+
+  // Import host input data
+  ProfScope importing("Importing data");
+  if (vecOpen(in0, &infile1) != 0)
+  { printf("Cannot open %s.\n", in0); exit(EXIT_FAILURE); }
+  if (vecOpen(in1, &infile2) != 0)
+  { printf("Cannot open %s.\n", in1); exit(EXIT_FAILURE); }
+  inputLength1 = infile1.length;
+  inputLength2 = infile2.length;
+  if (vecOpen(out, &outfile) != 0)
+  { printf("Cannot open %s.\n", out); exit(EXIT_FAILURE); }
+  outputLength = outfile.length;
+  hostOutput = (float *)malloc(sizeof(float) * inputLength1);
+  printf("Importing data and creating memory on host: %f ms\n", importing.stop() * 1e3);
+
+  if (blog) printf("*** The input length is %i\n", inputLength1);
+  if (inputLength2 != inputLength1 || outputLength != inputLength1)
+  { printf("Vector lengths differ: %i, %i and %i.\n", inputLength1, inputLength2, outputLength); exit(EXIT_FAILURE); }
+
+  ProfScope allocating("Allocating aligned memory");
+
+  // Allocate aligned compute memory
+  deviceOutput = alignedAlloc(outputLength);
+
+  printf("Allocating aligned memory: %f ms\n", allocating.stop() * 1e3);
+
+  ProfScope copying("Copying input memory");
+
+  // Copy the text inputs into aligned compute buffers, binary ones are used in place. The output is first
+  // touched here as well
+  deviceInput1 = computeBuffer(&infile1, &ownInput1);
+  deviceInput2 = computeBuffer(&infile2, &ownInput2);
+  deviceExpected = computeBuffer(&outfile, &ownExpected);
+  #pragma omp parallel for simd schedule(static)
+  for (int i = 0; i < outputLength; i++)
+    deviceOutput[i] = 0.0f;
+
+  printf("Copying input memory to the compute buffers: %f ms\n", copying.stop() * 1e3);
+
+  if (blog) printf("*** Thread count is %i\n", threads);
+
+  // Run the kernel reps times and keep the best time
+  double compute = 0.0;
+  float maxError = 0.0f;
+  for (int r = 0; r < reps; r++) {
+    ProfScope rep("CPU computation");
+    maxError = vecAddCheck(deviceInput1, deviceInput2, deviceExpected, deviceOutput, outputLength);
+    double elapsed = rep.stop();
+    if (r == 0 || elapsed < compute) compute = elapsed;
+  }
+
+  printf("Performing CPU computation: %f ms\n", compute * 1e3);
+
+  ProfScope copyingBack("Copying output memory");
+
+  // Copy the result back to the host output
+  parallelCopy(hostOutput, deviceOutput, outputLength);
+
+  printf("Copying output memory to the host: %f ms\n", copyingBack.stop() * 1e3);
+
+  ProfScope freeing("Freeing aligned memory");
+
+  // Free the compute memory
+  if (ownInput1) free((void *)deviceInput1);
+  if (ownInput2) free((void *)deviceInput2);
+  free(deviceOutput);
+  if (ownExpected) free((void *)deviceExpected);
+
+  printf("Freeing aligned memory: %f ms\n", freeing.stop() * 1e3);
+
+  if (maxError < 0.005f) printf("Results correct.\n");
+  else printf("Results incorrect.\n");
+  if (blog) printf("*** Largest error is %f\n", maxError);
+
+  // Compare the kernel with the machine's memory bandwidth
+  double kernelBandwidth = 4.0 * sizeof(float) * outputLength / compute / 1e9;
+  if (peak <= 0.0) peak = streamPeak(streamLength, reps);
+  printf("Effective kernel bandwidth: %f GB/s\n", kernelBandwidth);
+  printf("STREAM add bandwidth: %f GB/s\n", peak);
+  printf("Kernel reaches %.1f%% of STREAM\n", 100.0 * kernelBandwidth / peak);
+
+  vecClose(&infile1);
+  vecClose(&infile2);
+  free(hostOutput);
+  vecClose(&outfile);
+
+  profFinish();
+  return 0;
+}
@@ -0,0 +1,262 @@
+/**
+* NUMA placement and thread pinning for the OpenMP programs, with no library beyond the kernel interface.
+*
+*   numaAlloc(bytes, placement)   page aligned memory, placed by policy or left for the first touch
+*   numaPin("scatter", threads)   pins the OpenMP threads and prints where each one runs
+*
+* Placements:
+*   serial       the main thread touches everything, so all pages land on its node (the old behaviour)
+*   first        the program initializes the memory with the same OpenMP schedule its compute loops use,
+*                so every page lands on the node of the thread that works on it
+*   interleave   pages are spread round robin across all nodes with mbind, for access patterns that do
+*                not follow a static schedule
+*
+* Pinning: none, compact (thread t on the t-th allowed cpu), scatter (threads dealt round robin across
+* the nodes) or an explicit cpu list such as 0-7,16-23. Linux keeps an OpenMP thread on its cpu for every
+* later parallel region with the same number of threads, since those regions reuse the same threads.
+*
+* @since October 19, 2026
+*/
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+enum { NUMA_SERIAL, NUMA_FIRST_TOUCH, NUMA_INTERLEAVE, NUMA_PLACEMENTS };
+
+inline const char* numaPlacementName(int placement)
+{
+	static const char* names[NUMA_PLACEMENTS] = { "serial", "first", "interleave" };
+	return placement >= 0 && placement < NUMA_PLACEMENTS ? names[placement] : "unknown";
+}
+
+/* placement for a name, -1 if there is no such placement */
+inline int numaParsePlacement(const std::string& name)
+{
+	for (int x = 0; x < NUMA_PLACEMENTS; x++)
+		if (name == numaPlacementName(x))
+			return x;
+	return -1;
+}
+
+/* parse a kernel style list such as 0-3,8,10-11 */
+inline std::vector<int> numaParseList(const std::string& list)
+{
+	std::vector<int> items;
+	size_t pos = 0;
+	while (pos < list.size())
+	{
+		size_t end = list.find(',', pos);
+		if (end == std::string::npos)
+			end = list.size();
+		std::string range = list.substr(pos, end - pos);
+		size_t dash = range.find('-');
+		if (!range.empty() && range.find_first_not_of("0123456789-\n") == std::string::npos)
+		{
+			int low = atoi(range.c_str());
+			int high = dash == std::string::npos ? low : atoi(range.c_str() + dash + 1);
+			for (int x = low; x <= high; x++)
+				items.push_back(x);
+		}
+		pos = end + 1;
+	}
+	return items;
+}
+
+inline std::string numaReadLine(const std::string& path)
+{
+	char line[4096] = { 0 };
+	FILE* file = fopen(path.c_str(), "r");
+	if (file == NULL)
+		return "";
+	if (fgets(line, sizeof(line), file) == NULL)
+		line[0] = '\0';
+	fclose(file);
+	return line;
+}
+
+/* online nodes, just node 0 when the kernel does not report any */
+inline std::vector<int> numaNodes()
+{
+	std::vector<int> nodes = numaParseList(numaReadLine("/sys/devices/system/node/online"));
+	if (nodes.empty())
+		nodes.push_back(0);
+	return nodes;
+}
+
+/* node of every cpu the process may run on, indexed by cpu */
+inline std::vector<int> numaCpuNodes()
+{
+	std::vector<int> owner;
+	std::vector<int> nodes = numaNodes();
+	for (size_t x = 0; x < nodes.size(); x++)
+	{
+		char path[128];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[x]);
+		std::vector<int> cpus = numaParseList(numaReadLine(path));
+		for (size_t y = 0; y < cpus.size(); y++)
+		{
+			if (cpus[y] >= (int)owner.size())
+				owner.resize(cpus[y] + 1, 0);
+			owner[cpus[y]] = nodes[x];
+		}
+	}
+	return owner;
+}
+
+inline int numaNodeOf(const std::vector<int>& owner, int cpu)
+{
+	return cpu >= 0 && cpu < (int)owner.size() ? owner[cpu] : 0;
+}
+
+/* cpus in the affinity mask the process started with */
+inline std::vector<int> numaAllowedCpus()
+{
+	std::vector<int> cpus;
+	cpu_set_t set;
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+		for (int c = 0; c < CPU_SETSIZE; c++)
+			if (CPU_ISSET(c, &set))
+				cpus.push_back(c);
+	if (cpus.empty())
+		cpus.push_back(0);
+	return cpus;
+}
+
+/* page aligned memory that is not touched yet, interleaved across the nodes if asked, exits if the memory
+ * cannot be mapped just like a failed new would end the program
+ */
+inline void* numaAlloc(size_t bytes, int placement)
+{
+	if (bytes == 0)
+		bytes = 1;
+	void* memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		perror("numaAlloc");
+		exit(EXIT_FAILURE);
+	}
+	std::vector<int> nodes = numaNodes();
+	if (placement == NUMA_INTERLEAVE && nodes.size() > 1)
+	{
+		unsigned long mask[16] = { 0 };
+		const unsigned long bits = 8 * sizeof(unsigned long);
+		for (size_t x = 0; x < nodes.size(); x++)
+			if (nodes[x] < (int)(16 * bits))
+				mask[nodes[x] / bits] |= 1UL << (nodes[x] % bits);
+		if (syscall(SYS_mbind, memory, bytes, MPOL_INTERLEAVE, mask, 16 * bits, 0) != 0)
+			perror("mbind");
+	}
+	return memory;
+}
+
+inline void numaFree(void* memory, size_t bytes)
+{
+	if (memory != NULL)
+		munmap(memory, bytes == 0 ? 1 : bytes);
+}
+
+/* cpu for every thread under a pinning scheme, empty for none or an unknown scheme */
+inline std::vector<int> numaPinCpus(const std::string& scheme, int threads)
+{
+	std::vector<int> allowed = numaAllowedCpus(), plan;
+	if (scheme == "none" || scheme.empty())
+		return plan;
+
+	std::vector<int> order;
+	if (scheme == "compact")
+		order = allowed;
+	else if (scheme == "scatter")
+	{
+		// take one cpu from every node in turn
+		std::vector<int> owner = numaCpuNodes(), nodes = numaNodes();
+		std::vector<std::vector<int>> perNode(nodes.size());
+		size_t rounds = 0;
+		for (size_t c = 0; c < allowed.size(); c++)
+			for (size_t x = 0; x < nodes.size(); x++)
+				if (numaNodeOf(owner, allowed[c]) == nodes[x])
+					perNode[x].push_back(allowed[c]);
+		// cpus the kernel lists under no online node are left out, so stop after the largest node
+		for (size_t x = 0; x < perNode.size(); x++)
+			rounds = std::max(rounds, perNode[x].size());
+		for (size_t round = 0; round < rounds; round++)
+			for (size_t x = 0; x < perNode.size(); x++)
+				if (round < perNode[x].size())
+					order.push_back(perNode[x][round]);
+	}
+	else
+		order = numaParseList(scheme);
+	if (order.empty())
+		return plan;
+
+	for (int t = 0; t < threads; t++)
+		plan.push_back(order[t % order.size()]);
+	return plan;
+}
+
+/* pin the OpenMP threads of a team of the given size and print where every thread runs, returns -1 if the
+ * scheme is unknown or a thread could not be pinned
+ */
+inline int numaPin(const std::string& scheme, int threads)
+{
+	std::vector<int> plan = numaPinCpus(scheme, threads);
+	if (plan.empty() && scheme != "none" && !scheme.empty())
+	{
+		printf("Unknown pinning \"%s\", use none, compact, scatter or a cpu list\n", scheme.c_str());
+		return -1;
+	}
+	std::vector<int> where(threads, -1);
+	int failed = 0;
+
+	#pragma omp parallel num_threads(threads) reduction(+ : failed)
+	{
+		int me = 0;
+#ifdef _OPENMP
+		me = omp_get_thread_num();
+#endif
+		if (!plan.empty())
+		{
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(plan[me], &set);
+			if (sched_setaffinity(0, sizeof(set), &set) != 0)
+				failed++;
+		}
+		where[me] = sched_getcpu();
+	}
+
+	// list small teams thread by thread, large ones by node
+	std::vector<int> owner = numaCpuNodes(), nodes = numaNodes();
+	printf("Pinning %s, %d threads over %d NUMA node(s)\n", scheme.empty() ? "none" : scheme.c_str(), threads,
+		(int)nodes.size());
+	if (threads <= 16)
+		for (int t = 0; t < threads; t++)
+			printf("  thread %d on cpu %d, node %d\n", t, where[t], numaNodeOf(owner, where[t]));
+	else
+		for (size_t x = 0; x < nodes.size(); x++)
+		{
+			int count = 0;
+			for (int t = 0; t < threads; t++)
+				if (numaNodeOf(owner, where[t]) == nodes[x])
+					count++;
+			printf("  node %d: %d threads\n", nodes[x], count);
+		}
+	if (failed > 0)
+		printf("  %d threads could not be pinned\n", failed);
+	return failed > 0 ? -1 : 0;
+}
+
+#endif
@@ -0,0 +1,503 @@
+/**
+* A small header only profiling and tracing layer shared by every program in the repository.
+*
+*   ProfScope s("phase");          times the enclosing block, stop() ends it early and returns the seconds
+*   ProfWait w("MPI_Recv");        same, but counted as time spent waiting on MPI
+*   PROF_MPI("MPI_Recv", call);    runs one MPI call inside a ProfWait
+*   profFinish();                  prints the report if asked and writes the trace, call before MPI_Finalize
+*
+* Scopes are recorded per thread with no locking, so they can be used inside OpenMP parallel regions and
+* the report shows every thread's share of a phase. When mpi.h is included before this header the report
+* is gathered on rank 0 and shows the fastest, average and slowest rank for each phase, plus how much of
+* each rank's time was MPI wait.
+*
+* Environment variables:
+*   PROF_TRACE=file.json    write every scope as a Chrome trace event (chrome://tracing, Perfetto), with
+*                           more than one MPI rank each rank writes file.<rank>.json
+*   PROF_COUNTERS=1         read CPU cycles and cache misses with perf_event_open around every scope
+*   PROF_REPORT=1           print the report, off by default so the programs' own output stays the same
+*
+* @since October 19, 2026
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// kinds of scopes
+enum { PROF_COMPUTE, PROF_WAIT, PROF_WALL };
+
+// trace events kept per thread before new ones are dropped, the totals are always kept
+const size_t PROF_MAX_EVENTS = 1 << 20;
+// phases run on more threads than this only report the spread between threads
+const int PROF_LIST_THREADS = 16;
+
+// totals for one phase on one thread
+struct ProfStats
+{
+	const char* name;
+	int kind;
+	long long calls;
+	double total, min, max;
+	long long cycles, misses;
+};
+
+// one finished scope for the trace
+struct ProfEvent
+{
+	const char* name;
+	int kind;
+	double begin, end;
+	long long cycles, misses;
+};
+
+// everything one thread records, only that thread writes to it
+struct ProfThread
+{
+	int id;
+	int counterFd;
+	std::vector<ProfStats> stats;
+	std::vector<ProfEvent> events;
+	long long dropped;
+};
+
+struct ProfState
+{
+	std::mutex lock;
+	std::vector<ProfThread*> threads;
+	std::chrono::steady_clock::time_point start;
+	std::string trace;
+	bool counters;
+	bool report;
+	bool finished;
+
+	ProfState() : start(std::chrono::steady_clock::now()), counters(false), report(false), finished(false)
+	{
+		const char* env = getenv("PROF_TRACE");
+		if (env != NULL)
+			trace = env;
+		env = getenv("PROF_COUNTERS");
+		counters = env != NULL && atoi(env) != 0;
+		env = getenv("PROF_REPORT");
+		report = env != NULL && atoi(env) != 0;
+	}
+};
+
+inline ProfState& profState()
+{
+	static ProfState state;
+	return state;
+}
+
+/* seconds since the program started */
+inline double profNow()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - profState().start).count();
+}
+
+/* open a cycles + cache misses counter group for the calling thread, -1 if the kernel does not allow it */
+inline int profOpenCounters()
+{
+#ifdef __linux__
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.read_format = PERF_FORMAT_GROUP;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	int leader = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	if (leader < 0)
+		return -1;
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	int misses = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+	if (misses < 0)
+	{
+		close(leader);
+		return -1;
+	}
+	ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return leader;
+#else
+	return -1;
+#endif
+}
+
+/* current cycles and cache misses of the calling thread */
+inline void profReadCounters(int fd, long long& cycles, long long& misses)
+{
+	cycles = misses = 0;
+#ifdef __linux__
+	if (fd < 0)
+		return;
+	unsigned long long values[3];
+	if (read(fd, values, sizeof(values)) == (ssize_t)sizeof(values))
+	{
+		cycles = (long long)values[1];
+		misses = (long long)values[2];
+	}
+#endif
+}
+
+/* the calling thread's record, created the first time the thread opens a scope */
+inline ProfThread* profThread()
+{
+	static thread_local ProfThread* mine = NULL;
+	if (mine == NULL)
+	{
+		ProfState& state = profState();
+		mine = new ProfThread();
+		mine->dropped = 0;
+		mine->counterFd = -1;
+		std::lock_guard<std::mutex> guard(state.lock);
+		mine->id = (int)state.threads.size();
+		state.threads.push_back(mine);
+		if (state.counters)
+		{
+			mine->counterFd = profOpenCounters();
+			if (mine->counterFd < 0)
+			{
+				fprintf(stderr, "Profiler: perf_event_open failed, hardware counters are off\n");
+				state.counters = false;
+			}
+		}
+	}
+	return mine;
+}
+
+inline void profRecord(ProfThread* t, const char* name, int kind, double begin, double end, long long cycles,
+	long long misses)
+{
+	double seconds = end - begin;
+	ProfStats* s = NULL;
+	for (size_t x = 0; x < t->stats.size() && s == NULL; x++)
+		if (t->stats[x].name == name || strcmp(t->stats[x].name, name) == 0)
+			s = &t->stats[x];
+	if (s == NULL)
+	{
+		ProfStats fresh = { name, kind, 0, 0.0, seconds, seconds, 0, 0 };
+		t->stats.push_back(fresh);
+		s = &t->stats.back();
+	}
+	s->calls++;
+	s->total += seconds;
+	s->min = std::min(s->min, seconds);
+	s->max = std::max(s->max, seconds);
+	s->cycles += cycles;
+	s->misses += misses;
+
+	if (profState().trace.empty())
+		return;
+	if (t->events.size() < PROF_MAX_EVENTS)
+	{
+		ProfEvent e = { name, kind, begin, end, cycles, misses };
+		t->events.push_back(e);
+	}
+	else
+		t->dropped++;
+}
+
+/* times the enclosing block on the calling thread */
+class ProfScope
+{
+public:
+	explicit ProfScope(const char* phase, int scopeKind = PROF_COMPUTE)
+		: name(phase), kind(scopeKind), thread(profThread()), running(true), elapsed(0.0)
+	{
+		profReadCounters(thread->counterFd, cycles, misses);
+		begin = profNow();
+	}
+
+	~ProfScope()
+	{
+		stop();
+	}
+
+	/* end the scope before the block does, returns its length in seconds */
+	double stop()
+	{
+		if (!running)
+			return elapsed;
+		double end = profNow();
+		long long c, m;
+		profReadCounters(thread->counterFd, c, m);
+		running = false;
+		elapsed = end - begin;
+		profRecord(thread, name, kind, begin, end, c - cycles, m - misses);
+		return elapsed;
+	}
+
+private:
+	const char* name;
+	int kind;
+	ProfThread* thread;
+	bool running;
+	double begin, elapsed;
+	long long cycles, misses;
+};
+
+/* a scope spent blocked in MPI */
+class ProfWait : public ProfScope
+{
+public:
+	explicit ProfWait(const char* call) : ProfScope(call, PROF_WAIT) {}
+};
+
+// time one MPI call as MPI wait: PROF_MPI("MPI_Recv", MPI_Recv(...));
+#define PROF_MPI(name, call) do { ProfWait profWait(name); call; } while (0)
+
+// totals of one phase summed over the threads of a process
+struct ProfTotal
+{
+	std::string name;
+	int kind;
+	long long calls;
+	double total, min, max;
+	long long cycles, misses;
+	int threads;
+};
+
+/* combine every thread's stats by phase, in the order the phases were first seen */
+inline std::vector<ProfTotal> profTotals()
+{
+	ProfState& state = profState();
+	std::vector<ProfTotal> totals;
+	std::lock_guard<std::mutex> guard(state.lock);
+	for (size_t t = 0; t < state.threads.size(); t++)
+	{
+		const std::vector<ProfStats>& stats = state.threads[t]->stats;
+		for (size_t x = 0; x < stats.size(); x++)
+		{
+			size_t y = 0;
+			while (y < totals.size() && totals[y].name != stats[x].name)
+				y++;
+			if (y == totals.size())
+			{
+				ProfTotal fresh = { stats[x].name, stats[x].kind, 0, 0.0, stats[x].min, stats[x].max, 0, 0, 0 };
+				totals.push_back(fresh);
+			}
+			totals[y].calls += stats[x].calls;
+			totals[y].total += stats[x].total;
+			totals[y].min = std::min(totals[y].min, stats[x].min);
+			totals[y].max = std::max(totals[y].max, stats[x].max);
+			totals[y].cycles += stats[x].cycles;
+			totals[y].misses += stats[x].misses;
+			totals[y].threads++;
+		}
+	}
+	return totals;
+}
+
+/* print this process's phases, with every thread's share for phases run on more than one thread */
+inline void profPrintLocal(const std::vector<ProfTotal>& totals)
+{
+	ProfState& state = profState();
+	printf("\n%-32s %8s %12s %12s %12s %12s", "phase", "calls", "total ms", "mean ms", "min ms", "max ms");
+	if (state.counters)
+		printf(" %12s %12s", "Mcycles", "cache miss");
+	printf("\n");
+	for (size_t x = 0; x < totals.size(); x++)
+	{
+		const ProfTotal& p = totals[x];
+		printf("%-32s %8lld %12.3f %12.3f %12.3f %12.3f", p.name.c_str(), p.calls, p.total * 1e3,
+			p.total * 1e3 / p.calls, p.min * 1e3, p.max * 1e3);
+		if (state.counters)
+			printf(" %12.3f %12lld", p.cycles / 1e6, p.misses);
+		printf("\n");
+		if (p.threads < 2)
+			continue;
+
+		// list every thread for small teams, only the spread for large ones
+		double fastest = p.total, slowest = 0.0;
+		int slowThread = 0;
+		std::lock_guard<std::mutex> guard(state.lock);
+		for (size_t t = 0; t < state.threads.size(); t++)
+			for (size_t y = 0; y < state.threads[t]->stats.size(); y++)
+			{
+				const ProfStats& mine = state.threads[t]->stats[y];
+				if (p.name != mine.name)
+					continue;
+				if (p.threads <= PROF_LIST_THREADS)
+					printf("  thread %-23d %8lld %12.3f\n", state.threads[t]->id, mine.calls, mine.total * 1e3);
+				fastest = std::min(fastest, mine.total);
+				if (mine.total >= slowest)
+				{
+					slowest = mine.total;
+					slowThread = state.threads[t]->id;
+				}
+			}
+		if (p.threads > PROF_LIST_THREADS)
+			printf("  %d threads: fastest %.3f ms, average %.3f ms, slowest %.3f ms (thread %d)\n", p.threads,
+				fastest * 1e3, p.total * 1e3 / p.threads, slowest * 1e3, slowThread);
+	}
+}
+
+/* write the Chrome trace for this process */
+inline void profWriteTrace(int rank, int size)
+{
+	ProfState& state = profState();
+	std::string path = state.trace;
+	if (size > 1)
+	{
+		std::ostringstream suffix;
+		suffix << "." << rank;
+		size_t dot = path.rfind(".json");
+		if (dot != std::string::npos && dot + 5 == path.size())
+			path.insert(dot, suffix.str());
+		else
+			path += suffix.str();
+	}
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Profiler: cannot write %s\n", path.c_str());
+		return;
+	}
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}", rank, rank);
+	long long dropped = 0;
+	std::lock_guard<std::mutex> guard(state.lock);
+	for (size_t t = 0; t < state.threads.size(); t++)
+	{
+		const ProfThread* thread = state.threads[t];
+		dropped += thread->dropped;
+		for (size_t x = 0; x < thread->events.size(); x++)
+		{
+			const ProfEvent& e = thread->events[x];
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d",
+				e.name, e.kind == PROF_WAIT ? "mpi" : "compute", e.begin * 1e6, (e.end - e.begin) * 1e6, rank,
+				thread->id);
+			if (state.counters)
+				fprintf(file, ",\"args\":{\"cycles\":%lld,\"cache_misses\":%lld}", e.cycles, e.misses);
+			fprintf(file, "}");
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	if (dropped > 0)
+		fprintf(stderr, "Profiler: %lld trace events dropped after %zu per thread\n", dropped, PROF_MAX_EVENTS);
+}
+
+#ifdef MPI_VERSION
+/* gather every rank's phase totals on rank 0 and print the spread across ranks */
+inline void profPrintRanks(const std::vector<ProfTotal>& totals, int rank, int size)
+{
+	// each rank sends "kind calls total name" lines, the phases can differ between ranks
+	std::ostringstream out;
+	out.precision(17);
+	for (size_t x = 0; x < totals.size(); x++)
+		out << totals[x].kind << " " << totals[x].calls << " " << totals[x].total << " " << totals[x].name << "\n";
+	// wait scopes nest inside compute scopes, so the share of wait is taken against the rank's wall time
+	out << PROF_WALL << " 1 " << profNow() << " wall\n";
+	std::string mine = out.str();
+	int length = (int)mine.size();
+	std::vector<int> lengths(size), offsets(size, 0);
+	MPI_Gather(&length, 1, MPI_INT, &lengths[0], 1, MPI_INT, 0, MPI_COMM_WORLD);
+	for (int r = 1; r < size; r++)
+		offsets[r] = offsets[r - 1] + lengths[r - 1];
+	std::vector<char> all(rank == 0 ? offsets[size - 1] + lengths[size - 1] + 1 : 1);
+	MPI_Gatherv(&mine[0], length, MPI_CHAR, &all[0], &lengths[0], &offsets[0], MPI_CHAR, 0, MPI_COMM_WORLD);
+	if (rank != 0)
+		return;
+
+	// per phase: ranks that ran it, fastest, sum and slowest rank
+	struct rankTotal { std::string name; int kind; int ranks; double min, sum, max; int slowest; };
+	std::vector<rankTotal> phases;
+	std::vector<double> waits(size, 0.0), wall(size, 0.0);
+	for (int r = 0; r < size; r++)
+	{
+		std::istringstream in(std::string(&all[offsets[r]], lengths[r]));
+		int kind;
+		long long calls;
+		double total;
+		std::string name;
+		while (in >> kind >> calls >> total && std::getline(in >> std::ws, name))
+		{
+			if (kind == PROF_WALL)
+			{
+				wall[r] = total;
+				continue;
+			}
+			if (kind == PROF_WAIT)
+				waits[r] += total;
+			size_t y = 0;
+			while (y < phases.size() && phases[y].name != name)
+				y++;
+			if (y == phases.size())
+			{
+				rankTotal fresh = { name, kind, 0, total, 0.0, total, r };
+				phases.push_back(fresh);
+			}
+			phases[y].ranks++;
+			phases[y].sum += total;
+			phases[y].min = std::min(phases[y].min, total);
+			if (total >= phases[y].max)
+			{
+				phases[y].max = total;
+				phases[y].slowest = r;
+			}
+		}
+	}
+
+	printf("\n%-32s %6s %12s %12s %12s %8s\n", "phase (across ranks)", "ranks", "min ms", "avg ms", "max ms", "slowest");
+	for (size_t x = 0; x < phases.size(); x++)
+		printf("%-32s %6d %12.3f %12.3f %12.3f %8d%s\n", phases[x].name.c_str(), phases[x].ranks, phases[x].min * 1e3,
+			phases[x].sum * 1e3 / phases[x].ranks, phases[x].max * 1e3, phases[x].slowest,
+			phases[x].kind == PROF_WAIT ? "  (MPI wait)" : "");
+	printf("\n%-6s %12s %12s %8s\n", "rank", "wall ms", "MPI wait ms", "wait %");
+	for (int r = 0; r < size; r++)
+		printf("%-6d %12.3f %12.3f %7.1f%%\n", r, wall[r] * 1e3, waits[r] * 1e3,
+			wall[r] > 0.0 ? 100.0 * waits[r] / wall[r] : 0.0);
+}
+#endif
+
+/* print the report if PROF_REPORT is set and write the trace, MPI programs call this on every rank before MPI_Finalize */
+inline void profFinish()
+{
+	ProfState& state = profState();
+	if (state.finished)
+		return;
+	state.finished = true;
+	std::vector<ProfTotal> totals = profTotals();
+	int rank = 0, size = 1;
+#ifdef MPI_VERSION
+	int initialized = 0, finalized = 0;
+	MPI_Initialized(&initialized);
+	MPI_Finalized(&finalized);
+	if (initialized && !finalized)
+	{
+		MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+		MPI_Comm_size(MPI_COMM_WORLD, &size);
+	}
+#endif
+	if (state.report)
+	{
+		if (size == 1)
+			profPrintLocal(totals);
+#ifdef MPI_VERSION
+		else
+			profPrintRanks(totals, rank, size);
+#endif
+		fflush(stdout);
+	}
+	if (!state.trace.empty())
+		profWriteTrace(rank, size);
+}
+
+#endif
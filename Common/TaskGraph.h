@@ -0,0 +1,216 @@
+/**
+* A small work stealing task runtime for the OpenMP programs.
+*
+* Tasks are added in program order together with the data they read and write, and the graph derives the
+* dependencies the same way OpenMP's depend(in/out) clauses do: a task waits for the last writer of
+* everything it touches, and a write also waits for every reader since that writer. run() then executes
+* the whole graph without any barriers, a task starts as soon as its own inputs are ready.
+*
+*   TaskGraph graph;
+*   graph.add([&] { kernel(k, i, j); }, { tile(i, k), tile(k, j) }, { tile(i, j) });
+*   graph.run(threads);
+*
+* Every thread of the run owns a deque. Tasks that become ready go on the back of the deque of the thread
+* that finished their last input, the owner pops from the back to keep data it just touched in cache, and
+* idle threads steal from the front of the other deques. A graph can be run any number of times.
+*
+* @since October 19, 2026
+*/
+
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class TaskGraph
+{
+public:
+	typedef std::function<void()> Work;
+
+	TaskGraph() : stolen(0) {}
+
+	/* add a task that reads and writes the given addresses, returns its index */
+	int add(Work work, const std::vector<const void*>& reads, const std::vector<const void*>& writes)
+	{
+		int task = (int)tasks.size();
+		Task fresh;
+		fresh.work = work;
+		fresh.dependencies = 0;
+		tasks.push_back(fresh);
+
+		for (size_t x = 0; x < reads.size(); x++)
+		{
+			Access& a = accesses[reads[x]];
+			if (a.writer >= 0)
+				precede(a.writer, task);
+			a.readers.push_back(task);
+		}
+		for (size_t x = 0; x < writes.size(); x++)
+		{
+			Access& a = accesses[writes[x]];
+			if (a.writer >= 0)
+				precede(a.writer, task);
+			for (size_t y = 0; y < a.readers.size(); y++)
+				precede(a.readers[y], task);
+			a.writer = task;
+			a.readers.clear();
+		}
+		return task;
+	}
+
+	/* make after wait for before, on top of the dependencies add() found */
+	void precede(int before, int after)
+	{
+		// all edges into a task are added together, so a repeated edge is always the last one
+		std::vector<int>& next = tasks[before].successors;
+		if (before == after || (!next.empty() && next.back() == after))
+			return;
+		next.push_back(after);
+		tasks[after].dependencies++;
+	}
+
+	size_t size() const
+	{
+		return tasks.size();
+	}
+
+	/* tasks taken from another thread's deque in the last run */
+	long long steals() const
+	{
+		return stolen;
+	}
+
+	/* execute every task on the given number of threads */
+	void run(int threads)
+	{
+		if (threads < 1)
+			threads = 1;
+		std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[tasks.size()]);
+		// new only honours alignas(64) from C++17 on, so place the deques in memory aligned by hand
+		void* memory = NULL;
+		if (posix_memalign(&memory, alignof(TaskDeque), sizeof(TaskDeque) * threads) != 0)
+			throw std::bad_alloc();
+		TaskDeque* deques = static_cast<TaskDeque*>(memory);
+		for (int t = 0; t < threads; t++)
+			new (&deques[t]) TaskDeque();
+
+		// hand the tasks that are ready from the start out round robin
+		int next = 0;
+		for (size_t x = 0; x < tasks.size(); x++)
+		{
+			pending[x].store(tasks[x].dependencies, std::memory_order_relaxed);
+			if (tasks[x].dependencies == 0)
+				deques[next++ % threads].items.push_back((int)x);
+		}
+		std::atomic<long> remaining(tasks.size());
+		std::atomic<long long> steals(0);
+
+		#pragma omp parallel num_threads(threads)
+		{
+			int me = 0;
+#ifdef _OPENMP
+			me = omp_get_thread_num();
+#endif
+			int task;
+			unsigned victim = me;
+			while (remaining.load(std::memory_order_acquire) > 0)
+			{
+				if (!deques[me].popBack(task))
+				{
+					// look for work on the other threads, starting after the last one that had some
+					bool found = false;
+					for (int x = 1; x < threads && !found; x++)
+					{
+						victim = (victim + 1) % threads;
+						found = victim != (unsigned)me && deques[victim].popFront(task);
+					}
+					if (!found)
+					{
+						std::this_thread::yield();
+						continue;
+					}
+					steals.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				tasks[task].work();
+				const std::vector<int>& successors = tasks[task].successors;
+				for (size_t x = 0; x < successors.size(); x++)
+					if (pending[successors[x]].fetch_sub(1, std::memory_order_acq_rel) == 1)
+						deques[me].pushBack(successors[x]);
+				remaining.fetch_sub(1, std::memory_order_acq_rel);
+			}
+		}
+		stolen = steals.load();
+
+		for (int t = 0; t < threads; t++)
+			deques[t].~TaskDeque();
+		free(memory);
+	}
+
+private:
+	struct Task
+	{
+		Work work;
+		std::vector<int> successors;
+		int dependencies;
+	};
+
+	// last task to write an address and the tasks that read it since
+	struct Access
+	{
+		int writer;
+		std::vector<int> readers;
+		Access() : writer(-1) {}
+	};
+
+	// one thread's ready tasks, kept on its own cache lines
+	struct alignas(64) TaskDeque
+	{
+		std::mutex lock;
+		std::deque<int> items;
+
+		void pushBack(int task)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			items.push_back(task);
+		}
+
+		bool popBack(int& task)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (items.empty())
+				return false;
+			task = items.back();
+			items.pop_back();
+			return true;
+		}
+
+		bool popFront(int& task)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (items.empty())
+				return false;
+			task = items.front();
+			items.pop_front();
+			return true;
+		}
+	};
+
+	std::vector<Task> tasks;
+	std::unordered_map<const void*, Access> accesses;
+	long long stolen;
+};
+
+#endif
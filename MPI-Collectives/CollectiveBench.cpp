@@ -0,0 +1,428 @@
+/**
+* A C++ MPI benchmark that compares hand written collectives against the ones in the MPI library. Broadcast,
+* gather and allreduce (sum of doubles) are each implemented three ways:
+*
+*   linear   - rank 0 talks to every other rank in turn, like the termination loop in the hot potato
+*              programs and the gathers in the power ranking programs
+*   tree     - binomial tree rooted at rank 0, log2(p) rounds
+*   ring     - data travels around the ring in p - 1 steps, pipelined in segments for broadcast and split
+*              into reduce-scatter and allgather phases for allreduce
+*
+* and timed next to MPI_Bcast, MPI_Gather and MPI_Allreduce. Every algorithm runs on communicators of
+* 2, 4, 8, ... ranks up to the full job and for message sizes from 8 B to -maxsize bytes per rank. The
+* result of the last iteration is checked against the expected values and everything is written as CSV.
+*
+* usage: mpirun -np <procs> CollectiveBench [-iters n] [-minsize bytes] [-maxsize bytes] [-o results.csv]
+*
+* @since October 19, 2026
+*/
+
+#include <mpi.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include "../Common/Profiler.h"
+
+// every collective takes a send buffer, a receive buffer, a scratch buffer of p * count doubles and the
+// number of doubles each rank contributes
+typedef void (*collective)(double*, double*, double*, int, MPI_Comm);
+
+// one algorithm to benchmark
+struct algorithm
+{
+	const char* op;
+	const char* name;
+	// phase name in the profile, the profiler keeps the pointer
+	const char* label;
+	collective run;
+};
+
+// number of untimed iterations before every measurement
+const int WARMUP = 3;
+// total bytes moved per message size before the iteration count is cut down
+const long BYTE_BUDGET = 256L << 20;
+// segment size in doubles for the pipelined ring broadcast
+const int SEGMENT = 8192;
+
+// function prototypes
+void linearBcast(double*, double*, double*, int, MPI_Comm);
+void treeBcast(double*, double*, double*, int, MPI_Comm);
+void ringBcast(double*, double*, double*, int, MPI_Comm);
+void mpiBcast(double*, double*, double*, int, MPI_Comm);
+void linearGather(double*, double*, double*, int, MPI_Comm);
+void treeGather(double*, double*, double*, int, MPI_Comm);
+void ringGather(double*, double*, double*, int, MPI_Comm);
+void mpiGather(double*, double*, double*, int, MPI_Comm);
+void linearAllreduce(double*, double*, double*, int, MPI_Comm);
+void treeAllreduce(double*, double*, double*, int, MPI_Comm);
+void ringAllreduce(double*, double*, double*, int, MPI_Comm);
+void mpiAllreduce(double*, double*, double*, int, MPI_Comm);
+void fillInput(double*, double*, int, int, int, const std::string&);
+bool checkOutput(double*, int, int, int, const std::string&);
+
+const algorithm algorithms[] = {
+	{ "bcast", "linear", "bcast linear", linearBcast },
+	{ "bcast", "tree", "bcast tree", treeBcast },
+	{ "bcast", "ring", "bcast ring", ringBcast },
+	{ "bcast", "mpi", "bcast mpi", mpiBcast },
+	{ "gather", "linear", "gather linear", linearGather },
+	{ "gather", "tree", "gather tree", treeGather },
+	{ "gather", "ring", "gather ring", ringGather },
+	{ "gather", "mpi", "gather mpi", mpiGather },
+	{ "allreduce", "linear", "allreduce linear", linearAllreduce },
+	{ "allreduce", "tree", "allreduce tree", treeAllreduce },
+	{ "allreduce", "ring", "allreduce ring", ringAllreduce },
+	{ "allreduce", "mpi", "allreduce mpi", mpiAllreduce }
+};
+const int NUM_ALGORITHMS = sizeof(algorithms) / sizeof(algorithms[0]);
+
+int main(int argc, char** argv)
+{
+	// local variables
+	int rank, size;
+	int iters = 100;
+	long minsize = 8, maxsize = 1L << 20;
+	std::string results = "collective_bench.csv";
+
+	// initialize the MPI environment, get rank and size
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	// read the command line options
+	for (int x = 1; x + 1 < argc; x += 2)
+	{
+		std::string arg = argv[x];
+		if (arg == "-iters")
+			iters = std::max(atoi(argv[x + 1]), 1);
+		else if (arg == "-minsize")
+			minsize = atol(argv[x + 1]);
+		else if (arg == "-maxsize")
+			maxsize = atol(argv[x + 1]);
+		else if (arg == "-o")
+			results = argv[x + 1];
+	}
+	minsize = std::max(minsize, (long)sizeof(double));
+	maxsize = std::max(maxsize, minsize);
+
+	if (size < 2)
+	{
+		if (rank == 0)
+			std::cout << "ERROR: At least 2 processes are needed to compare collectives" << std::endl;
+		MPI_Finalize();
+		return 1;
+	}
+
+	std::ofstream csv;
+	if (rank == 0)
+	{
+		csv.open(results.c_str());
+		csv << "collective,algorithm,ranks,bytes,iterations,avg_us,max_us,correct" << std::endl;
+	}
+
+	// buffers big enough for a gather of the largest message on every rank
+	int maxcount = maxsize / sizeof(double);
+	std::vector<double> sendbuf(maxcount), recvbuf((size_t)maxcount * size), scratch((size_t)maxcount * size);
+
+	// rank counts 2, 4, 8, ... and the full job
+	std::vector<int> rankcounts;
+	for (int p = 2; p < size; p *= 2)
+		rankcounts.push_back(p);
+	rankcounts.push_back(size);
+
+	for (size_t r = 0; r < rankcounts.size(); r++)
+	{
+		int p = rankcounts[r];
+		MPI_Comm comm;
+		MPI_Comm_split(MPI_COMM_WORLD, rank < p ? 0 : MPI_UNDEFINED, rank, &comm);
+
+		for (long bytes = minsize; bytes <= maxsize; bytes *= 2)
+		{
+			int count = bytes / sizeof(double);
+			int n = (int)std::max(std::min((long)iters, BYTE_BUDGET / (bytes * p)), 5L);
+			for (int a = 0; a < NUM_ALGORITHMS; a++)
+			{
+				double avg = 0.0, slowest = 0.0;
+				int correct = 1;
+				if (comm != MPI_COMM_NULL)
+				{
+					fillInput(&sendbuf[0], &recvbuf[0], count, rank, p, algorithms[a].op);
+					MPI_Barrier(comm);
+					ProfScope timing(algorithms[a].label);
+					double start = 0.0;
+					for (int x = -WARMUP; x < n; x++)
+					{
+						if (x == 0)
+							start = MPI_Wtime();
+						algorithms[a].run(&sendbuf[0], &recvbuf[0], &scratch[0], count, comm);
+					}
+					double mine = (MPI_Wtime() - start) * 1e6 / n;
+					timing.stop();
+					int ok = checkOutput(&recvbuf[0], count, rank, p, algorithms[a].op);
+
+					// report the average and the slowest rank, and fail if any rank got the wrong answer
+					MPI_Reduce(&mine, &avg, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+					MPI_Reduce(&mine, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+					MPI_Reduce(&ok, &correct, 1, MPI_INT, MPI_MIN, 0, comm);
+					avg /= p;
+				}
+				if (rank == 0)
+					csv << algorithms[a].op << "," << algorithms[a].name << "," << p << "," << bytes << "," << n
+						<< "," << avg << "," << slowest << "," << (correct ? "yes" : "no") << std::endl;
+			}
+		}
+
+		if (comm != MPI_COMM_NULL)
+			MPI_Comm_free(&comm);
+		MPI_Barrier(MPI_COMM_WORLD);
+		if (rank == 0)
+			std::cout << "Finished " << p << " ranks" << std::endl;
+	}
+
+	if (rank == 0)
+	{
+		csv.close();
+		std::cout << "Results written to " << results << std::endl;
+	}
+	profFinish();
+
+	// finalize the MPI environment
+	MPI_Finalize();
+	return 0;
+}
+
+/* rank 0 sends the buffer to every other rank one at a time */
+void linearBcast(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	if (rank == 0)
+	{
+		for (int dest = 1; dest < size; dest++)
+			MPI_Send(recv, count, MPI_DOUBLE, dest, 1, comm);
+	}
+	else
+		MPI_Recv(recv, count, MPI_DOUBLE, 0, 1, comm, MPI_STATUS_IGNORE);
+}
+
+/* binomial tree, in round i every rank below 2^i that has the data sends it to rank + 2^i */
+void treeBcast(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	for (int mask = 1; mask < size; mask *= 2)
+	{
+		if (rank < mask && rank + mask < size)
+			MPI_Send(recv, count, MPI_DOUBLE, rank + mask, 1, comm);
+		else if (rank >= mask && rank < 2 * mask)
+			MPI_Recv(recv, count, MPI_DOUBLE, rank - mask, 1, comm, MPI_STATUS_IGNORE);
+	}
+}
+
+/* the buffer travels down the ring in segments so every link is busy at the same time */
+void ringBcast(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	for (int offset = 0; offset < count; offset += SEGMENT)
+	{
+		int len = std::min(SEGMENT, count - offset);
+		if (rank > 0)
+			MPI_Recv(recv + offset, len, MPI_DOUBLE, rank - 1, 1, comm, MPI_STATUS_IGNORE);
+		if (rank < size - 1)
+			MPI_Send(recv + offset, len, MPI_DOUBLE, rank + 1, 1, comm);
+	}
+}
+
+void mpiBcast(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	MPI_Bcast(recv, count, MPI_DOUBLE, 0, comm);
+}
+
+/* every rank sends its block straight to rank 0 */
+void linearGather(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	if (rank == 0)
+	{
+		std::copy(send, send + count, recv);
+		for (int src = 1; src < size; src++)
+			MPI_Recv(recv + (size_t)src * count, count, MPI_DOUBLE, src, 1, comm, MPI_STATUS_IGNORE);
+	}
+	else
+		MPI_Send(send, count, MPI_DOUBLE, 0, 1, comm);
+}
+
+/* binomial tree, every rank collects the blocks of its subtree and passes them up in one message */
+void treeGather(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	// blocks are stored starting at this rank's own block, rank 0 collects straight into recv
+	double* blocks = rank == 0 ? recv : tmp;
+	std::copy(send, send + count, blocks);
+	for (int mask = 1; mask < size; mask *= 2)
+	{
+		if (rank & mask)
+		{
+			int have = std::min(mask, size - rank);
+			MPI_Send(blocks, have * count, MPI_DOUBLE, rank - mask, 1, comm);
+			break;
+		}
+		else if (rank + mask < size)
+		{
+			int incoming = std::min(mask, size - rank - mask);
+			MPI_Recv(blocks + (size_t)mask * count, incoming * count, MPI_DOUBLE, rank + mask, 1, comm,
+				MPI_STATUS_IGNORE);
+		}
+	}
+}
+
+/* blocks flow from the last rank towards rank 0, each rank adds its own block in front */
+void ringGather(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	// the blocks are kept at their final offsets so nothing has to be moved
+	double* blocks = rank == 0 ? recv : tmp;
+	std::copy(send, send + count, blocks + (size_t)rank * count);
+	if (rank < size - 1)
+		MPI_Recv(blocks + (size_t)(rank + 1) * count, (size - rank - 1) * count, MPI_DOUBLE, rank + 1, 1, comm,
+			MPI_STATUS_IGNORE);
+	if (rank > 0)
+		MPI_Send(blocks + (size_t)rank * count, (size - rank) * count, MPI_DOUBLE, rank - 1, 1, comm);
+}
+
+void mpiGather(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	MPI_Gather(send, count, MPI_DOUBLE, recv, count, MPI_DOUBLE, 0, comm);
+}
+
+/* rank 0 receives and adds every rank's buffer, then sends the sum back one rank at a time */
+void linearAllreduce(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	std::copy(send, send + count, recv);
+	if (rank == 0)
+	{
+		for (int src = 1; src < size; src++)
+		{
+			MPI_Recv(tmp, count, MPI_DOUBLE, src, 1, comm, MPI_STATUS_IGNORE);
+			for (int x = 0; x < count; x++)
+				recv[x] += tmp[x];
+		}
+	}
+	else
+		MPI_Send(send, count, MPI_DOUBLE, 0, 1, comm);
+	linearBcast(send, recv, tmp, count, comm);
+}
+
+/* binomial tree reduction to rank 0 followed by a binomial tree broadcast */
+void treeAllreduce(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	std::copy(send, send + count, recv);
+	for (int mask = 1; mask < size; mask *= 2)
+	{
+		if (rank & mask)
+		{
+			MPI_Send(recv, count, MPI_DOUBLE, rank - mask, 1, comm);
+			break;
+		}
+		else if (rank + mask < size)
+		{
+			MPI_Recv(tmp, count, MPI_DOUBLE, rank + mask, 1, comm, MPI_STATUS_IGNORE);
+			for (int x = 0; x < count; x++)
+				recv[x] += tmp[x];
+		}
+	}
+	treeBcast(send, recv, tmp, count, comm);
+}
+
+/* ring reduce-scatter leaves every rank with the sum of one chunk, a ring allgather then passes the
+ * finished chunks around. Each rank sends 2 * (p - 1) / p of the buffer no matter how many ranks there are.
+ */
+void ringAllreduce(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	int rank, size;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	std::copy(send, send + count, recv);
+	int next = (rank + 1) % size, prev = (rank - 1 + size) % size;
+
+	// chunk c covers [c * count / p, (c + 1) * count / p)
+	std::vector<int> starts(size + 1);
+	for (int c = 0; c <= size; c++)
+		starts[c] = (int)((long)c * count / size);
+
+	// reduce-scatter, after step s rank r holds the partial sum of chunk r - s - 1 from s + 2 ranks
+	for (int step = 0; step < size - 1; step++)
+	{
+		int out = (rank - step + size) % size, in = (rank - step - 1 + size) % size;
+		MPI_Sendrecv(recv + starts[out], starts[out + 1] - starts[out], MPI_DOUBLE, next, 1,
+			tmp, starts[in + 1] - starts[in], MPI_DOUBLE, prev, 1, comm, MPI_STATUS_IGNORE);
+		for (int x = starts[in]; x < starts[in + 1]; x++)
+			recv[x] += tmp[x - starts[in]];
+	}
+
+	// allgather, rank r starts with the finished chunk r + 1
+	for (int step = 0; step < size - 1; step++)
+	{
+		int out = (rank - step + 1 + size) % size, in = (rank - step + size) % size;
+		MPI_Sendrecv(recv + starts[out], starts[out + 1] - starts[out], MPI_DOUBLE, next, 1,
+			recv + starts[in], starts[in + 1] - starts[in], MPI_DOUBLE, prev, 1, comm, MPI_STATUS_IGNORE);
+	}
+}
+
+void mpiAllreduce(double* send, double* recv, double* tmp, int count, MPI_Comm comm)
+{
+	MPI_Allreduce(send, recv, count, MPI_DOUBLE, MPI_SUM, comm);
+}
+
+/* small integers keep the sums exact so results can be compared with == */
+void fillInput(double* send, double* recv, int count, int rank, int size, const std::string& op)
+{
+	for (int x = 0; x < count; x++)
+	{
+		send[x] = rank + x % 7;
+		// only the root's receive buffer holds data before a broadcast
+		recv[x] = op == "bcast" && rank == 0 ? x % 7 : -1.0;
+	}
+	// clear every block of the root's gather buffer so nothing is left over from the previous algorithm
+	if (op == "gather" && rank == 0)
+		for (size_t x = count; x < (size_t)size * count; x++)
+			recv[x] = -1.0;
+}
+
+/* check the last iteration's output, gathers are only checked on rank 0 */
+bool checkOutput(double* recv, int count, int rank, int size, const std::string& op)
+{
+	for (int x = 0; x < count; x++)
+	{
+		if (op == "bcast" && recv[x] != x % 7)
+			return false;
+		if (op == "allreduce" && recv[x] != (double)size * (size - 1) / 2 + (double)size * (x % 7))
+			return false;
+		if (op == "gather" && rank == 0)
+			for (int r = 0; r < size; r++)
+				if (recv[(size_t)r * count + x] != r + x % 7)
+					return false;
+	}
+	return true;
+}
@@ -12,6 +12,7 @@
 #include <iostream>
 #include <time.h>
 #include <cstdlib>
+#include "../Common/Profiler.h"
 
 int main(int argc, char** argv) {
 	// local variables
@@ -37,10 +38,10 @@ int main(int argc, char** argv) {
 		potato -= 1;
 
 		// send potato to random destination
-		MPI_Send(&potato, 1, MPI_INT, dest, 1, MPI_COMM_WORLD);
+		PROF_MPI("MPI_Send", MPI_Send(&potato, 1, MPI_INT, dest, 1, MPI_COMM_WORLD));
 
 		// wait for potato to come back
-		MPI_Recv(&potato, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+		PROF_MPI("MPI_Recv", MPI_Recv(&potato, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
 	}
 
 	// else other process besides 0
@@ -52,7 +53,7 @@ int main(int argc, char** argv) {
 		while (!over) {
 
 			// receive the potato
-			MPI_Recv(&potato, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+			PROF_MPI("MPI_Recv", MPI_Recv(&potato, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
 
 			if (potato > 0)
 			{
@@ -61,7 +62,7 @@ int main(int argc, char** argv) {
 				} while (dest == rank);
 				potato -= 1;
 				std::cout << "Node " << rank << " has the potato, passing it to node " << dest << std::endl;
-				MPI_Send(&potato, 1, MPI_INT, dest, 1, MPI_COMM_WORLD);
+				PROF_MPI("MPI_Send", MPI_Send(&potato, 1, MPI_INT, dest, 1, MPI_COMM_WORLD));
 			}
 
 			else if (potato == 0)
@@ -71,7 +72,7 @@ int main(int argc, char** argv) {
 				potato = -1;
 				for (dest = 0; dest < size; dest++)
 					if (dest != rank)
-						MPI_Send(&potato, 1, MPI_INT, dest, 1, MPI_COMM_WORLD);
+						PROF_MPI("MPI_Send", MPI_Send(&potato, 1, MPI_INT, dest, 1, MPI_COMM_WORLD));
 					over = true;
 			}
 
@@ -82,6 +83,9 @@ int main(int argc, char** argv) {
 		}
 	}
 
+	// print the profile on every rank before shutting down MPI
+	profFinish();
+
 	// finalize the MPI environment.
 	MPI_Finalize();
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <iostream>
 #include <time.h>
 #include <cstdlib>
+#include "../Common/Profiler.h"
 
 int main(int argc, char** argv) {
 	// local variables
@@ -36,10 +37,10 @@ int main(int argc, char** argv) {
 		dest = rand() % (size - 1) + 1;
 		
 		// send potato to random destination
-		MPI_Send(length, 1, MPI_INT, dest, 1, MPI_COMM_WORLD);
+		PROF_MPI("MPI_Send", MPI_Send(length, 1, MPI_INT, dest, 1, MPI_COMM_WORLD));
 
 		// wait for potato to come back
-		MPI_Recv(length, potato + 2, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+		PROF_MPI("MPI_Recv", MPI_Recv(length, potato + 2, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
 		
 		// get the message size and print out the data
 		MPI_Get_count(&status, MPI_INT, &arrsize);	
@@ -60,7 +61,7 @@ int main(int argc, char** argv) {
 		while (!over) {
 
 			// receive the potato
-			MPI_Recv(length, potato + 2, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+			PROF_MPI("MPI_Recv", MPI_Recv(length, potato + 2, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
 			
 			// if potato isnt 0 keep passing it
 			if (length[0] > 0)
@@ -71,7 +72,7 @@ int main(int argc, char** argv) {
 				MPI_Get_count(&status, MPI_INT, &arrsize);
 				length[0] -= 1;
 				length[arrsize] = rank;
-				MPI_Send(length, arrsize + 1, MPI_INT, dest, 1, MPI_COMM_WORLD);
+				PROF_MPI("MPI_Send", MPI_Send(length, arrsize + 1, MPI_INT, dest, 1, MPI_COMM_WORLD));
 			}
 
 			// if potato is 0 have process send termination message
@@ -82,7 +83,7 @@ int main(int argc, char** argv) {
 				length[potato + 1] = rank;
 				for (dest = 0; dest < size; dest++)
 					if (dest != rank)
-						MPI_Send(length, potato + 2, MPI_INT, dest, 1, MPI_COMM_WORLD);
+						PROF_MPI("MPI_Send", MPI_Send(length, potato + 2, MPI_INT, dest, 1, MPI_COMM_WORLD));
 				over = true;
 			}
 			
@@ -94,6 +95,9 @@ int main(int argc, char** argv) {
 		}
 	}
 
+	// print the profile on every rank before shutting down MPI
+	profFinish();
+
 	// finalize the MPI environment
 	MPI_Finalize();
 }
\ No newline at end of file
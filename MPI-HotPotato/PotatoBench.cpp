@@ -0,0 +1,634 @@
+/**
+* A point-to-point benchmark suite built on the hot potato game. Two tests are run for every message size
+* from 8 B to 64 MB (doubling each step):
+*
+*   pingpong - rank 0 and rank 1 bounce the potato back and forth, one-way latency is half a round trip
+*   walk     - the potato is passed between random ranks like HotPotato.cpp and returns to rank 0 after a
+*              fixed number of hops, the latency sample is the walk time divided by the hops
+*
+* Each test is repeated with three send modes: blocking (MPI_Send/MPI_Recv), nonblocking
+* (MPI_Isend/MPI_Irecv) and synchronous (MPI_Ssend). In nonblocking mode a rank posts its next receive
+* before it sends: the sender of a round trip posts the MPI_Irecv for the reply before its MPI_Isend and
+* completes both with MPI_Waitall, and a rank passing the potato on posts the receive for the next one
+* into a second buffer before forwarding. Most messages then find their receive already posted, although
+* the first message of a ping-pong can still arrive before the other rank has posted its receive.
+* MPI_Send uses the eager protocol for small messages while MPI_Ssend always waits for the matching
+* receive like the rendezvous protocol, so the size where the two curves meet is the eager limit of the
+* MPI library. Latency percentiles and bandwidth are written as CSV to the results file and the latency
+* histograms (power of two microsecond buckets) to the histogram file.
+*
+* With -mode storm the sweep is replaced by a message rate stress test. Every rank starts with -tokens
+* potatoes of -tokensize bytes and keeps forwarding them to its neighbors (rank + 1, 2, 4, ... mod size)
+* until each has made -hops hops. Sends and receives are persistent requests over preallocated buffers,
+* -window of them per neighbor, and the end of the game is found with a distributed four counter
+* termination detection: idle ranks join nonblocking allreduce waves of their sent and received counts,
+* and the game is over when two waves in a row see the same totals with nothing in flight.
+*
+* usage: mpirun -np <procs> PotatoBench [-iters n] [-minsize bytes] [-maxsize bytes] [-hops n]
+*                                       [-o results.csv] [-hist histogram.csv]
+*        mpirun -np <procs> PotatoBench -mode storm [-tokens n] [-tokensize bytes] [-window n] [-hops n]
+*                                       [-o results.csv]
+*
+* @since October 19, 2026
+*/
+
+#include "mpi.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "../Common/Profiler.h"
+
+// send modes compared by every test
+enum sendMode { BLOCKING, NONBLOCKING, SYNCHRONOUS };
+const char* modeNames[] = { "blocking", "nonblocking", "synchronous" };
+
+// benchmark settings, changed with command line options
+struct settings
+{
+	int iters;
+	long minsize;
+	long maxsize;
+	int hops;
+	std::string mode;
+	int tokens;
+	int tokensize;
+	int window;
+	std::string results;
+	std::string histogram;
+};
+
+// statistics for one test, mode and message size
+struct result
+{
+	std::string test;
+	int mode;
+	long bytes;
+	std::vector<double> samples;
+};
+
+// number of untimed iterations before every measurement
+const int WARMUP = 5;
+// total bytes moved per message size before the iteration count is cut down
+const long BYTE_BUDGET = 1L << 30;
+// a synchronous send this much slower than a standard send means the standard send went eager
+const double EAGER_GAP = 1.2;
+
+// header carried by every potato in the stress test
+struct token
+{
+	int hops;
+	int origin;
+};
+
+// the receiving end of a test, in nonblocking mode the next receive is always posted into the buffer that
+// is not being passed on
+struct receiver
+{
+	int mode;
+	char* buffers[2];
+	int current;
+	MPI_Request pending;
+};
+
+// function prototypes
+settings parseArgs(int, char**);
+int iterationsFor(const settings&, long);
+void sendPotato(int, char*, long, int);
+void recvPotato(char*, long, int);
+void roundTrip(int, char*, char*, long, int, int);
+void startReceiving(receiver&, int, char*, char*, long, int);
+char* awaitPotato(receiver&, long, int);
+void expectPotato(receiver&, long, int);
+void pingPong(int, int, int, char*, char*, long, result&);
+void randomWalk(int, int, int, char*, char*, long, int, int, result&);
+double percentile(const std::vector<double>&, double);
+double writeResults(std::ofstream&, std::ofstream&, const result&);
+void potatoStorm(int, int, const settings&);
+
+int main(int argc, char** argv) {
+	// local variables
+	int rank, size;
+
+	// initialize the MPI environment, get rank and size
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	if (size < 2)
+	{
+		if (rank == 0)
+			std::cout << "ERROR: At least 2 processes are needed to pass the potato" << std::endl;
+		MPI_Finalize();
+		return 1;
+	}
+
+	settings opts = parseArgs(argc, argv);
+
+	// the stress test replaces the latency sweep
+	if (opts.mode == "storm")
+	{
+		ProfScope storm("storm");
+		potatoStorm(rank, size, opts);
+		storm.stop();
+		profFinish();
+		MPI_Finalize();
+		return 0;
+	}
+
+	// open the output files on the master process
+	std::ofstream csv, hist;
+	if (rank == 0)
+	{
+		csv.open(opts.results.c_str());
+		hist.open(opts.histogram.c_str());
+		csv << "test,mode,bytes,iterations,min_us,mean_us,p50_us,p90_us,p99_us,max_us,bandwidth_MBps" << std::endl;
+		hist << "test,mode,bytes,bucket_low_us,bucket_high_us,count" << std::endl;
+	}
+
+	// the potato carries the whole message, the first int holds the hop count
+	char* potato = new char[opts.maxsize];
+	char* spare = new char[opts.maxsize];
+	memset(potato, 0, opts.maxsize);
+	memset(spare, 0, opts.maxsize);
+
+	// largest size where MPI_Ssend was clearly slower than MPI_Send
+	long eagerlimit = 0;
+
+	// seed random generator with rank so everyone has different numbers
+	srand(rank + 1);
+
+	for (long bytes = opts.minsize; bytes <= opts.maxsize; bytes *= 2)
+	{
+		int iters = iterationsFor(opts, bytes);
+		double sendmedian = 0.0;
+		for (int mode = BLOCKING; mode <= SYNCHRONOUS; mode++)
+		{
+			result pp = { "pingpong", mode, bytes, std::vector<double>() };
+			MPI_Barrier(MPI_COMM_WORLD);
+			ProfScope pingTime("pingpong");
+			pingPong(rank, mode, iters, potato, spare, bytes, pp);
+			pingTime.stop();
+			if (rank == 0)
+			{
+				double median = writeResults(csv, hist, pp);
+				if (mode == BLOCKING)
+					sendmedian = median;
+				// eager sends skip the handshake that synchronous sends always pay for
+				else if (mode == SYNCHRONOUS && median > EAGER_GAP * sendmedian)
+					eagerlimit = bytes;
+			}
+
+			// a random walk needs at least two ranks besides the master
+			if (size > 2)
+			{
+				result walk = { "walk", mode, bytes, std::vector<double>() };
+				MPI_Barrier(MPI_COMM_WORLD);
+				ProfScope walkTime("random walk");
+				randomWalk(rank, size, mode, potato, spare, bytes, iters, opts.hops, walk);
+				walkTime.stop();
+				if (rank == 0)
+					writeResults(csv, hist, walk);
+			}
+		}
+		if (rank == 0)
+			std::cout << "Finished " << bytes << " byte potatoes" << std::endl;
+	}
+
+	if (rank == 0)
+	{
+		csv.close();
+		hist.close();
+		if (eagerlimit > 0)
+			std::cout << "Estimated eager limit: " << eagerlimit << " bytes" << std::endl;
+		else
+			std::cout << "No eager protocol detected between " << opts.minsize << " and " << opts.maxsize << " bytes" << std::endl;
+		std::cout << "Results written to " << opts.results << " and " << opts.histogram << std::endl;
+	}
+
+	delete[] potato;
+	delete[] spare;
+	profFinish();
+
+	// finalize the MPI environment
+	MPI_Finalize();
+	return 0;
+}
+
+/* read the command line options, anything not given keeps its default */
+settings parseArgs(int argc, char** argv)
+{
+	settings opts = { 1000, 8, 64L << 20, 0, "sweep", 1000, (int)sizeof(token), 8, "", "potato_hist.csv" };
+	for (int x = 1; x + 1 < argc; x += 2)
+	{
+		std::string arg = argv[x];
+		if (arg == "-iters")
+			opts.iters = atoi(argv[x + 1]);
+		else if (arg == "-minsize")
+			opts.minsize = atol(argv[x + 1]);
+		else if (arg == "-maxsize")
+			opts.maxsize = atol(argv[x + 1]);
+		else if (arg == "-hops")
+			opts.hops = atoi(argv[x + 1]);
+		else if (arg == "-mode")
+			opts.mode = argv[x + 1];
+		else if (arg == "-tokens")
+			opts.tokens = atoi(argv[x + 1]);
+		else if (arg == "-tokensize")
+			opts.tokensize = atoi(argv[x + 1]);
+		else if (arg == "-window")
+			opts.window = atoi(argv[x + 1]);
+		else if (arg == "-o")
+			opts.results = argv[x + 1];
+		else if (arg == "-hist")
+			opts.histogram = argv[x + 1];
+	}
+	// the hop counter needs room in the message
+	opts.minsize = std::max(opts.minsize, (long)sizeof(int));
+	opts.maxsize = std::max(opts.maxsize, opts.minsize);
+	opts.iters = std::max(opts.iters, 1);
+	opts.tokensize = std::max(opts.tokensize, (int)sizeof(token));
+	opts.window = std::max(opts.window, 1);
+	if (opts.results == "")
+		opts.results = opts.mode == "storm" ? "potato_storm.csv" : "potato_bench.csv";
+	return opts;
+}
+
+/* large messages get fewer iterations so every size moves about the same amount of data */
+int iterationsFor(const settings& opts, long bytes)
+{
+	long iters = BYTE_BUDGET / bytes;
+	if (iters > opts.iters)
+		iters = opts.iters;
+	if (iters < 10)
+		iters = std::min(10, opts.iters);
+	return (int)iters;
+}
+
+/* send the potato using the given mode, in nonblocking mode the receiver has its receive posted already */
+void sendPotato(int mode, char* buf, long bytes, int dest)
+{
+	if (mode == NONBLOCKING)
+	{
+		MPI_Request req;
+		MPI_Isend(buf, bytes, MPI_BYTE, dest, 1, MPI_COMM_WORLD, &req);
+		MPI_Wait(&req, MPI_STATUS_IGNORE);
+	}
+	else if (mode == SYNCHRONOUS)
+		MPI_Ssend(buf, bytes, MPI_BYTE, dest, 1, MPI_COMM_WORLD);
+	else
+		MPI_Send(buf, bytes, MPI_BYTE, dest, 1, MPI_COMM_WORLD);
+}
+
+/* blocking receive of the potato, source can be MPI_ANY_SOURCE */
+void recvPotato(char* buf, long bytes, int source)
+{
+	MPI_Recv(buf, bytes, MPI_BYTE, source, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+/* send buf to dest and wait for the potato to come back from source. In nonblocking mode the reply is
+ * received into spare with its MPI_Irecv posted before the MPI_Isend, and both complete in one MPI_Waitall.
+ */
+void roundTrip(int mode, char* buf, char* spare, long bytes, int dest, int source)
+{
+	if (mode == NONBLOCKING)
+	{
+		MPI_Request reqs[2];
+		MPI_Irecv(spare, bytes, MPI_BYTE, source, 1, MPI_COMM_WORLD, &reqs[0]);
+		MPI_Isend(buf, bytes, MPI_BYTE, dest, 1, MPI_COMM_WORLD, &reqs[1]);
+		MPI_Waitall(2, reqs, MPI_STATUSES_IGNORE);
+	}
+	else
+	{
+		sendPotato(mode, buf, bytes, dest);
+		recvPotato(buf, bytes, source);
+	}
+}
+
+/* get ready to receive potatoes, in nonblocking mode the first receive is posted right away */
+void startReceiving(receiver& r, int mode, char* buf, char* spare, long bytes, int source)
+{
+	r.mode = mode;
+	r.buffers[0] = buf;
+	r.buffers[1] = spare;
+	r.current = 0;
+	if (mode == NONBLOCKING)
+		MPI_Irecv(buf, bytes, MPI_BYTE, source, 1, MPI_COMM_WORLD, &r.pending);
+}
+
+/* wait for the next potato and return the buffer it is in */
+char* awaitPotato(receiver& r, long bytes, int source)
+{
+	if (r.mode == NONBLOCKING)
+		MPI_Wait(&r.pending, MPI_STATUS_IGNORE);
+	else
+		recvPotato(r.buffers[r.current], bytes, source);
+	return r.buffers[r.current];
+}
+
+/* post the receive for the potato after the one just returned by awaitPotato, before that one is sent on */
+void expectPotato(receiver& r, long bytes, int source)
+{
+	if (r.mode != NONBLOCKING)
+		return;
+	r.current = 1 - r.current;
+	MPI_Irecv(r.buffers[r.current], bytes, MPI_BYTE, source, 1, MPI_COMM_WORLD, &r.pending);
+}
+
+/* rank 0 and rank 1 pass the potato back and forth, rank 0 records half of every round trip */
+void pingPong(int rank, int mode, int iters, char* buf, char* spare, long bytes, result& res)
+{
+	if (rank == 0)
+	{
+		for (int x = -WARMUP; x < iters; x++)
+		{
+			double start = MPI_Wtime();
+			roundTrip(mode, buf, spare, bytes, 1, 1);
+			double finish = MPI_Wtime();
+			if (x >= 0)
+				res.samples.push_back((finish - start) * 1e6 / 2);
+		}
+	}
+	else if (rank == 1)
+	{
+		receiver r;
+		startReceiving(r, mode, buf, spare, bytes, 0);
+		for (int x = -WARMUP; x < iters; x++)
+		{
+			char* potato = awaitPotato(r, bytes, 0);
+			if (x + 1 < iters)
+				expectPotato(r, bytes, 0);
+			sendPotato(mode, potato, bytes, 0);
+		}
+	}
+}
+
+/* rank 0 starts a walk of the given number of hops between random ranks and times it until the potato
+ * comes back. After the last walk rank 0 sends -1 to every rank to end the test.
+ */
+void randomWalk(int rank, int size, int mode, char* buf, char* spare, long bytes, int iters, int hops, result& res)
+{
+	int* hopcount = (int*)buf;
+	if (hops <= 0)
+		hops = 2 * size;
+
+	// if master process 0
+	if (rank == 0)
+	{
+		for (int x = -WARMUP; x < iters; x++)
+		{
+			int dest = rand() % (size - 1) + 1;
+			*hopcount = hops - 1;
+			double start = MPI_Wtime();
+			roundTrip(mode, buf, spare, bytes, dest, MPI_ANY_SOURCE);
+			double finish = MPI_Wtime();
+			if (x >= 0)
+				res.samples.push_back((finish - start) * 1e6 / hops);
+		}
+		// send the termination message
+		*hopcount = -1;
+		for (int dest = 1; dest < size; dest++)
+			sendPotato(mode, buf, bytes, dest);
+	}
+
+	// else other process besides 0
+	else
+	{
+		receiver r;
+		startReceiving(r, mode, buf, spare, bytes, MPI_ANY_SOURCE);
+		while (true)
+		{
+			char* potato = awaitPotato(r, bytes, MPI_ANY_SOURCE);
+			hopcount = (int*)potato;
+			if (*hopcount < 0)
+				break;
+
+			// the last hop always goes back to the master
+			int dest = 0;
+			if (*hopcount > 1)
+			{
+				do {
+					dest = rand() % (size - 1) + 1;
+				} while (dest == rank);
+			}
+			*hopcount -= 1;
+			expectPotato(r, bytes, MPI_ANY_SOURCE);
+			sendPotato(mode, potato, bytes, dest);
+		}
+	}
+}
+
+/* nearest rank percentile of sorted samples */
+double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0.0;
+	size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/* write one line of statistics and the histogram buckets for a finished measurement, returns the median */
+double writeResults(std::ofstream& csv, std::ofstream& hist, const result& res)
+{
+	std::vector<double> sorted = res.samples;
+	std::sort(sorted.begin(), sorted.end());
+	if (sorted.empty())
+		return 0.0;
+
+	double mean = 0.0;
+	for (size_t x = 0; x < sorted.size(); x++)
+		mean += sorted[x];
+	mean /= sorted.size();
+	double median = percentile(sorted, 50);
+
+	csv << res.test << "," << modeNames[res.mode] << "," << res.bytes << "," << sorted.size() << ","
+		<< sorted.front() << "," << mean << "," << median << "," << percentile(sorted, 90) << ","
+		<< percentile(sorted, 99) << "," << sorted.back() << "," << res.bytes / median << std::endl;
+
+	// bucket 0 holds everything under 1 us, bucket b holds [2^(b-1), 2^b) us
+	std::vector<int> buckets;
+	for (size_t x = 0; x < sorted.size(); x++)
+	{
+		size_t b = 0;
+		for (double limit = 1.0; sorted[x] >= limit; limit *= 2)
+			b++;
+		if (buckets.size() <= b)
+			buckets.resize(b + 1, 0);
+		buckets[b]++;
+	}
+	for (size_t b = 0; b < buckets.size(); b++)
+	{
+		if (buckets[b] == 0)
+			continue;
+		double low = b == 0 ? 0.0 : (double)(1L << (b - 1));
+		hist << res.test << "," << modeNames[res.mode] << "," << res.bytes << "," << low << ","
+			<< (double)(1L << b) << "," << buckets[b] << std::endl;
+	}
+	return median;
+}
+
+/* message rate stress test, thousands of potatoes are passed around at once through persistent requests */
+void potatoStorm(int rank, int size, const settings& opts)
+{
+	int hops = opts.hops > 0 ? opts.hops : 100;
+	int window = opts.window;
+	int tokensize = opts.tokensize;
+	srand(rank + 1);
+
+	// potatoes go to rank + 2^i and come from rank - 2^i, so every rank has the same number of each
+	std::vector<int> outs, ins;
+	for (int step = 1; step < size; step *= 2)
+	{
+		outs.push_back((rank + step) % size);
+		ins.push_back((rank - step + size) % size);
+	}
+	int neighbors = outs.size();
+	int slots = neighbors * window;
+
+	// preallocate every buffer and bind a persistent request to each of them
+	std::vector<char> sendbufs((size_t)slots * tokensize, 0), recvbufs((size_t)slots * tokensize, 0);
+	std::vector<MPI_Request> sendreqs(slots), recvreqs(slots);
+	std::vector<std::vector<int> > freeslots(neighbors);
+	for (int n = 0; n < neighbors; n++)
+	{
+		for (int w = 0; w < window; w++)
+		{
+			int slot = n * window + w;
+			MPI_Send_init(&sendbufs[(size_t)slot * tokensize], tokensize, MPI_BYTE, outs[n], 2, MPI_COMM_WORLD,
+				&sendreqs[slot]);
+			MPI_Recv_init(&recvbufs[(size_t)slot * tokensize], tokensize, MPI_BYTE, ins[n], 2, MPI_COMM_WORLD,
+				&recvreqs[slot]);
+			freeslots[n].push_back(slot);
+		}
+	}
+	MPI_Startall(slots, &recvreqs[0]);
+
+	// potatoes waiting on this rank for a free send slot
+	std::vector<token> pending;
+	pending.reserve((size_t)opts.tokens + slots);
+	for (int x = 0; x < opts.tokens; x++)
+	{
+		token t = { hops, rank };
+		pending.push_back(t);
+	}
+
+	std::vector<int> done(slots);
+	long long sent = 0, received = 0, retired = 0;
+	long long counts[2], totals[2], lastwave[2] = { -1, -1 };
+	long long waves = 0;
+	size_t maxpending = pending.size();
+	bool inwave = false, over = false;
+	MPI_Request wave;
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	double start = MPI_Wtime();
+
+	while (!over)
+	{
+		// free the slots of finished sends
+		int finished;
+		MPI_Testsome(slots, &sendreqs[0], &finished, &done[0], MPI_STATUSES_IGNORE);
+		for (int x = 0; finished != MPI_UNDEFINED && x < finished; x++)
+			freeslots[done[x] / window].push_back(done[x]);
+
+		// take arriving potatoes and repost their receives right away
+		MPI_Testsome(slots, &recvreqs[0], &finished, &done[0], MPI_STATUSES_IGNORE);
+		for (int x = 0; finished != MPI_UNDEFINED && x < finished; x++)
+		{
+			token t;
+			memcpy(&t, &recvbufs[(size_t)done[x] * tokensize], sizeof(token));
+			pending.push_back(t);
+			received++;
+			MPI_Start(&recvreqs[done[x]]);
+		}
+		maxpending = std::max(maxpending, pending.size());
+
+		// pass on as many potatoes as there are free slots, trying a random neighbor first
+		while (!pending.empty())
+		{
+			token& t = pending.back();
+			if (t.hops == 0)
+			{
+				retired++;
+				pending.pop_back();
+				continue;
+			}
+			int first = rand() % neighbors, n = -1;
+			for (int y = 0; y < neighbors && n < 0; y++)
+				if (!freeslots[(first + y) % neighbors].empty())
+					n = (first + y) % neighbors;
+			if (n < 0)
+				break;
+			int slot = freeslots[n].back();
+			freeslots[n].pop_back();
+			t.hops -= 1;
+			memcpy(&sendbufs[(size_t)slot * tokensize], &t, sizeof(token));
+			MPI_Start(&sendreqs[slot]);
+			sent++;
+			pending.pop_back();
+		}
+
+		// an idle rank joins the next termination wave
+		if (!inwave && pending.empty())
+		{
+			counts[0] = sent;
+			counts[1] = received;
+			MPI_Iallreduce(counts, totals, 2, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD, &wave);
+			inwave = true;
+			waves++;
+		}
+
+		// every rank sees the same totals so they all stop after the same wave
+		if (inwave)
+		{
+			int flag;
+			MPI_Test(&wave, &flag, MPI_STATUS_IGNORE);
+			if (flag)
+			{
+				inwave = false;
+				over = totals[0] == totals[1] && totals[0] == lastwave[0] && totals[1] == lastwave[1];
+				lastwave[0] = totals[0];
+				lastwave[1] = totals[1];
+			}
+		}
+	}
+
+	double elapsed = MPI_Wtime() - start;
+
+	// nothing is in flight anymore, retire the receives still posted and release every request
+	MPI_Waitall(slots, &sendreqs[0], MPI_STATUSES_IGNORE);
+	for (int x = 0; x < slots; x++)
+	{
+		MPI_Cancel(&recvreqs[x]);
+		MPI_Wait(&recvreqs[x], MPI_STATUS_IGNORE);
+		MPI_Request_free(&sendreqs[x]);
+		MPI_Request_free(&recvreqs[x]);
+	}
+
+	// gather the totals on the master process
+	double maxelapsed;
+	long long localstats[2] = { retired, (long long)maxpending }, sums[2], maxima[2];
+	MPI_Reduce(&elapsed, &maxelapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	MPI_Reduce(localstats, sums, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	MPI_Reduce(localstats, maxima, 2, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	if (rank == 0)
+	{
+		double rate = totals[0] / maxelapsed;
+		std::ofstream csv(opts.results.c_str());
+		csv << "ranks,tokens,tokensize,hops,window,messages,retired,seconds,msgs_per_s,msgs_per_s_per_rank,"
+			<< "bandwidth_MBps,waves,max_pending" << std::endl;
+		csv << size << "," << (long long)opts.tokens * size << "," << tokensize << "," << hops << "," << window << ","
+			<< totals[0] << "," << sums[0] << "," << maxelapsed << "," << rate << "," << rate / size << ","
+			<< rate * tokensize / 1e6 << "," << waves << "," << maxima[1] << std::endl;
+		csv.close();
+		std::cout << totals[0] << " potatoes passed in " << maxelapsed << " s (" << rate << " messages/s), "
+			<< waves << " termination waves" << std::endl;
+		if (sums[0] != (long long)opts.tokens * size)
+			std::cout << "ERROR: only " << sums[0] << " potatoes finished their hops" << std::endl;
+		std::cout << "Results written to " << opts.results << std::endl;
+	}
+}
@@ -3,7 +3,8 @@
 * using jacobi iteration. Each process of 8 receives four teamnames and their corresponding scores, constructs
 * the power equation with an initial guess of 100, and sends the new power rating to eachother using basic send
 * and receives. This continues in a loop until the relative error for each process is less than 0.05 or correct 
-* up to one decimal place.
+* up to one decimal place. Any other process count that divides 32 also works, each process then gets
+* 32 / size teams.
 *
 * @since October 13, 2016
 * @author Alec J. Horne
@@ -17,20 +18,26 @@
 #include <iomanip>
 #include <cmath>
 #include <sstream>
+#include "../PowerSolver.h"
+#include "../../Common/Profiler.h"
+
+// 32 teams, four per process on the usual 8 processes, other process counts use the runtime sized solver
+typedef PowerSolver<32, 4> NFLSolver;
+typedef PowerSolver<POWER_DYNAMIC, POWER_DYNAMIC> AnySizeSolver;
 
 // function prototypes
+template <class Solver>
+int runJacobi(Solver&, int[][32], int[], int[], int, int, double[], double);
 int isDone(double[], double, int, double[]);
-void numGamesPlayed(int[][32], int[]);
+void numGamesPlayed(int[][32], int[], int);
 
 int main(int argc, char** argv)
 {
 	// local process variables
-	int rank, size, done, iterations;
-	iterations = done = 0;
+	int rank, size, iterations;
 	double tolerance = 0.05;
-	int mycoeffs[4][32], mysums[4];
-	double oldpowers[4], newpowers[4] = { 100.0, 100.0, 100.0, 100.0 };
-	int numgames[4] = { 0, 0, 0, 0 };
+	int mycoeffs[32][32], mysums[32];
+	int numgames[32] = { 0 };
 	MPI_Status status;
 
 	// initialize the MPI environment, get rank and size
@@ -50,14 +57,17 @@ int main(int argc, char** argv)
 		for (int y = 0; y < 32; y++)
 			coeff[x][y] = 0;
 
-	// make sure that process size is 8 for algorithm to work properly
-	if (size % 8 != 0)
+	// make sure that the teams split evenly over the processes for algorithm to work properly
+	if (32 % size != 0)
 	{
 		if (rank == 0)
-			std::cout << "ERROR: Process size must be 8 to run this program" << std::endl;
+			std::cout << "ERROR: Process size must divide 32 to run this program" << std::endl;
 		MPI_Finalize();
 		return -1;
 	}
+	int perrank = 32 / size;
+
+	ProfScope reading("read input");
 
 	// if rank is 0, read the files and distribute the data
 	if (rank == 0)
@@ -101,7 +111,7 @@ int main(int argc, char** argv)
 		}
 		infile.close();
 
-		// distribute equal data amounts to each process - each process gets 4 teams
+		// distribute equal data amounts to each process - each process gets perrank teams
 		// offset is equal to processor size and splits up data in an equal organized way
 		for (int i = 0; i < size; i++)
 		{
@@ -109,109 +119,138 @@ int main(int argc, char** argv)
 			if (i == 0)
 			{
 				int offset = 0;
-				for (int x = 0; x < 4; x++)
+				for (int x = 0; x < perrank; x++)
 				{
 					mysums[x] = sums[offset];
 					for (int y = 0; y < 32; y++)
 						mycoeffs[x][y] = coeff[offset][y];
-					offset += 8;
+					offset += size;
 				}
 			}
 			// send data to each process from global arrays
 			else
 			{
 				int offset = 0;
-				for (int x = 0; x < 4; x++)
+				for (int x = 0; x < perrank; x++)
 				{
-					MPI_Send(coeff[i + offset], 32, MPI_INT, i, 1, MPI_COMM_WORLD);
-					MPI_Send(&sums[i + offset], 1, MPI_INT, i, 1, MPI_COMM_WORLD);
-					offset += 8;
+					PROF_MPI("MPI_Send", MPI_Send(coeff[i + offset], 32, MPI_INT, i, 1, MPI_COMM_WORLD));
+					PROF_MPI("MPI_Send", MPI_Send(&sums[i + offset], 1, MPI_INT, i, 1, MPI_COMM_WORLD));
+					offset += size;
 				}
 			}
 		}
 	}
 
-	// if process besides 0, receive the 4 teams assigned to corresponding process data
+	// if process besides 0, receive the teams assigned to corresponding process data
 	else
 	{
-		for (int i = 0; i < 4; i++)
+		for (int i = 0; i < perrank; i++)
 		{
-			MPI_Recv(mycoeffs[i], 32, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-			MPI_Recv(&mysums[i], 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+			PROF_MPI("MPI_Recv", MPI_Recv(mycoeffs[i], 32, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
+			PROF_MPI("MPI_Recv", MPI_Recv(&mysums[i], 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
 		}
 	}
 
+	reading.stop();
+
 	// get the correct number of games played for each team for use in power equation
-	numGamesPlayed(mycoeffs, numgames);
+	numGamesPlayed(mycoeffs, numgames, perrank);
+
+	// the usual 8 processes run the kernel compiled for 4 teams each, any other split the runtime sized one
+	ProfScope jacobi("jacobi update");
+	if (size == 8)
+	{
+		NFLSolver solver;
+		iterations = runJacobi(solver, mycoeffs, mysums, numgames, rank, size, power, tolerance);
+	}
+	else
+	{
+		AnySizeSolver solver(32, perrank);
+		iterations = runJacobi(solver, mycoeffs, mysums, numgames, rank, size, power, tolerance);
+	}
+	jacobi.stop();
 
-	// every iteration compute new power rating for each processes 4 teams and send to master
+	// output data to the console
+	if (rank == 0) {
+		for (int x = 0; x < 32; x++)
+			std::cout << teamnames[x] << " power is " << power[x] << std::endl;
+		std::cout << std::endl;
+		std::cout << "Jacobi's method took " << iterations << " iterations to complete with an error tolerance of "
+			<< tolerance << std::endl;
+	}
+
+	profFinish();
+
+	// finalize the MPI environment and return
+	MPI_Finalize();
+	return 0;
+}
+
+/* Function that runs jacobi iterations with the given solver until every power rating is within the
+ * tolerance, and returns the number of iterations it took.
+ */
+template <class Solver>
+int runJacobi(Solver& solver, int mycoeffs[][32], int mysums[], int numgames[], int rank, int size,
+	double power[], double tolerance)
+{
+	int done = 0, iterations = 0;
+	int perrank = solver.perRank();
+	double oldpowers[32], newpowers[32];
+	MPI_Status status;
+	for (int z = 0; z < perrank; z++)
+	{
+		solver.setTeam(z, mycoeffs[z], mysums[z], numgames[z]);
+		newpowers[z] = 100.0;
+	}
+
+	// every iteration compute new power rating for each processes teams and send to master
 	while (true) {
-		int offset = 0;
-		for (int z = 0; z < 4; z++)
-		{
+		for (int z = 0; z < perrank; z++)
 			oldpowers[z] = newpowers[z];
-			newpowers[z] = 0.0;
-			for (int x = 0; x < 32; x++)
-				newpowers[z] += mycoeffs[z][x] * power[x];
-			newpowers[z] += mysums[z];
-			newpowers[z] /= numgames[z];
-			offset += 8;
-		}
+		solver.update(power, newpowers);
 		// if rank is 0 update the power rankings array with newly computed values
 		if (rank == 0)
 		{
-			offset = 0;
-			for (int x = 0; x < 4; x++)
+			int offset = 0;
+			for (int x = 0; x < perrank; x++)
 			{
 				power[offset] = newpowers[x];
-				offset += 8;
+				offset += size;
 			}
 			// receive the new values from each process and update the power rankings array
 			for (int i = 1; i < size; i++)
 			{
 				offset = 0;
-				double temp[4];
-				MPI_Recv(temp, 4, MPI_DOUBLE, i, 0, MPI_COMM_WORLD, &status);
-				for (int x = 0; x < 4; x++)
+				double temp[32];
+				PROF_MPI("MPI_Recv", MPI_Recv(temp, perrank, MPI_DOUBLE, i, 0, MPI_COMM_WORLD, &status));
+				for (int x = 0; x < perrank; x++)
 				{
 					power[i + offset] = temp[x];
-					offset += 8;
+					offset += size;
 				}
 			}
 			// check if the values are in specified tolerance/relative error
 			done = isDone(oldpowers, tolerance, size, power);
 			iterations += 1;
 			for (int i = 1; i < size; i++) {
-				MPI_Send(&done, 1, MPI_INT, i, 1, MPI_COMM_WORLD);
-				MPI_Send(power, 32, MPI_DOUBLE, i, 1, MPI_COMM_WORLD);
+				PROF_MPI("MPI_Send", MPI_Send(&done, 1, MPI_INT, i, 1, MPI_COMM_WORLD));
+				PROF_MPI("MPI_Send", MPI_Send(power, 32, MPI_DOUBLE, i, 1, MPI_COMM_WORLD));
 			}
 		}
 		
 		// if not process 0 then send info to process 0 and receive updated power rankings array
 		else
 		{
-			MPI_Send(newpowers, 4, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
-			MPI_Send(oldpowers, 4, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
-			MPI_Recv(&done, 1, MPI_INT, 0, 1, MPI_COMM_WORLD, &status);
-			MPI_Recv(power, 32, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD, &status);
+			PROF_MPI("MPI_Send", MPI_Send(newpowers, perrank, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD));
+			PROF_MPI("MPI_Send", MPI_Send(oldpowers, perrank, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD));
+			PROF_MPI("MPI_Recv", MPI_Recv(&done, 1, MPI_INT, 0, 1, MPI_COMM_WORLD, &status));
+			PROF_MPI("MPI_Recv", MPI_Recv(power, 32, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD, &status));
 		}
 		// if all values are in tolerance then break the loop and stop calculations
 		if (done == -1)
 			break;
 	}
-
-	// output data to the console
-	if (rank == 0) {
-		for (int x = 0; x < 32; x++)
-			std::cout << teamnames[x] << " power is " << power[x] << std::endl;
-		std::cout << std::endl;
-		std::cout << "Jacobi's method took " << iterations << " iterations to complete with an error tolerance of "
-			<< tolerance << std::endl;
-	}
-
-	// finalize the MPI environment and return
-	MPI_Finalize();
-	return 0;
+	return iterations;
 }
 
 /* Function to check if the values are within the specified tolerance. If they are, signal to
@@ -221,24 +260,25 @@ int isDone(double op[], double tol, int size, double ps[])
 {
 	MPI_Status status;
 	double *oldpowers = new double[32];
-	double temp[4];
+	double temp[32];
+	int perrank = 32 / size;
 	int offset = 0;
 	// gather process 0s previous power rankings
-	for (int y = 0; y < 4; y++)
+	for (int y = 0; y < perrank; y++)
 	{
 		oldpowers[offset] = op[y];
-		offset += 8;
+		offset += size;
 	}
 
 	// receive every other processes previous power rankings and add them to array
 	for (int i = 1; i < size; i++)
 	{
 		offset = 0;
-		MPI_Recv(temp, 4, MPI_DOUBLE, i, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-		for (int x = 0; x < 4; x++)
+		PROF_MPI("MPI_Recv", MPI_Recv(temp, perrank, MPI_DOUBLE, i, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
+		for (int x = 0; x < perrank; x++)
 		{
 			oldpowers[i + offset] = temp[x];
-			offset += 8;
+			offset += size;
 		}
 	}
 	
@@ -255,10 +295,10 @@ int isDone(double op[], double tol, int size, double ps[])
 /* Function that each process calls to get the correct number of games each team has played for
  * calculations. In the NFL each teams games played amounts are different.
  */
-void numGamesPlayed(int arr[][32], int gp[])
+void numGamesPlayed(int arr[][32], int gp[], int teams)
 {
-	//count number of games played for each of the processes 4 teams
-	for (int x = 0; x < 4; x++)
+	//count number of games played for each of the processes teams
+	for (int x = 0; x < teams; x++)
 		for (int y = 0; y < 32; y++)
 			if (arr[x][y] == 1)
 				gp[x]++;
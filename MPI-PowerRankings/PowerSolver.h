@@ -0,0 +1,142 @@
+/**
+* Jacobi update kernel shared by the XFL and NFL power ranking programs. Each process owns PER_RANK teams
+* of a league of TEAMS teams and every iteration computes, for each of its teams,
+*
+*     newpower = (sum over opponents of games[opponent] * power[opponent] + point differential) / games played
+*
+* When TEAMS and PER_RANK are known at compile time the coefficient rows are stored as aligned doubles and
+* the dot product is fully unrolled into independent accumulators so the whole update runs out of registers
+* and L1. PowerSolver<POWER_DYNAMIC, POWER_DYNAMIC> is the runtime sized fallback for leagues of any other size.
+*
+* @since October 19, 2026
+*/
+
+#ifndef POWERSOLVER_H
+#define POWERSOLVER_H
+
+#include <vector>
+
+// template argument that selects the runtime sized solver
+const int POWER_DYNAMIC = 0;
+
+// number of independent partial sums used by the dot products, enough to fill two SIMD registers
+const int POWER_LANES = 4;
+static_assert(POWER_LANES > 0 && (POWER_LANES & (POWER_LANES - 1)) == 0, "POWER_LANES must be a power of two");
+
+/* add the lanes pairwise, (acc[0] + acc[2]) + (acc[1] + acc[3]) for four lanes */
+inline double laneSum(double acc[])
+{
+	for (int width = POWER_LANES / 2; width > 0; width /= 2)
+		for (int l = 0; l < width; l++)
+			acc[l] += acc[l + width];
+	return acc[0];
+}
+
+/* Dot product of a coefficient row and the power array with a trip count fixed at compile time. The
+ * lanes are summed separately and combined at the end so the compiler can vectorize the loop.
+ */
+template <int N>
+inline double fixedDot(const double row[], const double power[])
+{
+	double acc[POWER_LANES] = {};
+	#pragma GCC unroll 64
+	for (int x = 0; x + POWER_LANES <= N; x += POWER_LANES)
+		for (int l = 0; l < POWER_LANES; l++)
+			acc[l] += row[x + l] * power[x + l];
+	#pragma GCC unroll 64
+	for (int x = N - N % POWER_LANES; x < N; x++)
+		acc[x % POWER_LANES] += row[x] * power[x];
+	return laneSum(acc);
+}
+
+/* Same dot product for a row length only known at run time */
+inline double dynamicDot(const double row[], const double power[], int n)
+{
+	double acc[POWER_LANES] = {};
+	int x = 0;
+	for (; x + POWER_LANES <= n; x += POWER_LANES)
+		for (int l = 0; l < POWER_LANES; l++)
+			acc[l] += row[x + l] * power[x + l];
+	for (; x < n; x++)
+		acc[x % POWER_LANES] += row[x] * power[x];
+	return laneSum(acc);
+}
+
+template <int TEAMS, int PER_RANK>
+class PowerSolver
+{
+public:
+	PowerSolver()
+	{
+		for (int z = 0; z < PER_RANK; z++)
+		{
+			for (int x = 0; x < TEAMS; x++)
+				coeffs[z][x] = 0.0;
+			sums[z] = 0.0;
+			games[z] = 1.0;
+		}
+	}
+
+	int teams() const { return TEAMS; }
+	int perRank() const { return PER_RANK; }
+
+	/* store the z-th team owned by this process: games against each opponent, point differential
+	 * and number of games played
+	 */
+	void setTeam(int z, const int row[], int sum, int played)
+	{
+		for (int x = 0; x < TEAMS; x++)
+			coeffs[z][x] = row[x];
+		sums[z] = sum;
+		games[z] = played;
+	}
+
+	/* compute the new power rating of every team owned by this process */
+	void update(const double power[], double newpowers[]) const
+	{
+		#pragma GCC unroll 8
+		for (int z = 0; z < PER_RANK; z++)
+			newpowers[z] = (fixedDot<TEAMS>(coeffs[z], power) + sums[z]) / games[z];
+	}
+
+private:
+	alignas(64) double coeffs[PER_RANK][TEAMS];
+	double sums[PER_RANK];
+	double games[PER_RANK];
+};
+
+template <>
+class PowerSolver<POWER_DYNAMIC, POWER_DYNAMIC>
+{
+public:
+	PowerSolver(int numteams, int teamsperrank)
+		: nteams(numteams), nperrank(teamsperrank), coeffs(numteams * teamsperrank, 0.0),
+		sums(teamsperrank, 0.0), games(teamsperrank, 1.0)
+	{
+	}
+
+	int teams() const { return nteams; }
+	int perRank() const { return nperrank; }
+
+	void setTeam(int z, const int row[], int sum, int played)
+	{
+		for (int x = 0; x < nteams; x++)
+			coeffs[z * nteams + x] = row[x];
+		sums[z] = sum;
+		games[z] = played;
+	}
+
+	void update(const double power[], double newpowers[]) const
+	{
+		for (int z = 0; z < nperrank; z++)
+			newpowers[z] = (dynamicDot(&coeffs[z * nteams], power, nteams) + sums[z]) / games[z];
+	}
+
+private:
+	int nteams, nperrank;
+	std::vector<double> coeffs;
+	std::vector<double> sums;
+	std::vector<double> games;
+};
+
+#endif
@@ -17,6 +17,11 @@
 #include <iomanip>
 #include <cmath>
 #include <sstream>
+#include "../PowerSolver.h"
+#include "../../Common/Profiler.h"
+
+// 8 teams, one per process
+typedef PowerSolver<8, 1> XFLSolver;
 
 // function prototype
 int isDone(double, double, int, double[]);
@@ -49,6 +54,8 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
+	ProfScope reading("read input");
+
 	// if rank is 0, read the files and distribute the data
 	if (rank == 0)
 	{
@@ -86,8 +93,8 @@ int main(int argc, char** argv)
 				awaydif = awayscore - homescore;
 				// send the data to both the home and away teams
 				if (home != 1) {
-					MPI_Send(&away, 1, MPI_INT, home - 1, 1, MPI_COMM_WORLD);
-					MPI_Send(&homedif, 1, MPI_INT, home - 1, 1, MPI_COMM_WORLD);
+					PROF_MPI("MPI_Send", MPI_Send(&away, 1, MPI_INT, home - 1, 1, MPI_COMM_WORLD));
+					PROF_MPI("MPI_Send", MPI_Send(&homedif, 1, MPI_INT, home - 1, 1, MPI_COMM_WORLD));
 				}
 				else
 				{
@@ -95,8 +102,8 @@ int main(int argc, char** argv)
 					coeff[away - 1]++;
 				}
 				if (away != 1) {
-					MPI_Send(&home, 1, MPI_INT, away - 1, 1, MPI_COMM_WORLD);
-					MPI_Send(&awaydif, 1, MPI_INT, away - 1, 1, MPI_COMM_WORLD);
+					PROF_MPI("MPI_Send", MPI_Send(&home, 1, MPI_INT, away - 1, 1, MPI_COMM_WORLD));
+					PROF_MPI("MPI_Send", MPI_Send(&awaydif, 1, MPI_INT, away - 1, 1, MPI_COMM_WORLD));
 				} 
 				else
 				{
@@ -114,42 +121,47 @@ int main(int argc, char** argv)
 		// receive team scores and opponents
 		for (int x = 0; x < 10; x++)
 		{
-			MPI_Recv(&team, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-			MPI_Recv(&score, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+			PROF_MPI("MPI_Recv", MPI_Recv(&team, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
+			PROF_MPI("MPI_Recv", MPI_Recv(&score, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
 			sum += score;
 			coeff[team - 1]++;
 		}
 	}
 
+	reading.stop();
+
+	// every team plays 10 games
+	XFLSolver solver;
+	solver.setTeam(0, coeff, sum, 10);
+
+	ProfScope jacobi("jacobi update");
 	// for each iteration compute the new power rating and send it to the other processes
 	while (true) 
 	{
-		double newpower = 0.0;
+		double newpower;
 		double oldpower = power[rank];
-		for (int x = 0; x < 8; x++)
-			newpower += coeff[x] * power[x];
-		newpower += sum;
-		newpower /= 10;
+		solver.update(power, &newpower);
 		// updates the power array with newly computed values from each process
-		MPI_Allgather(&newpower, 1, MPI_DOUBLE, &power, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+		PROF_MPI("MPI_Allgather", MPI_Allgather(&newpower, 1, MPI_DOUBLE, &power, 1, MPI_DOUBLE, MPI_COMM_WORLD));
 		iterations++;
 		// if rank 0 check if values are within the specified tolerance
 		if (rank == 0) 
 		{
 			done = isDone(oldpower, tolerance, size, power);
 			for (int i = 1; i < size; i++)
-				MPI_Send(&done, 1, MPI_INT, i, 1, MPI_COMM_WORLD);
+				PROF_MPI("MPI_Send", MPI_Send(&done, 1, MPI_INT, i, 1, MPI_COMM_WORLD));
 		}
 		// if other rank send the old power value to process 0 and receive the "done" flag
 		else
 		{
-			MPI_Send(&oldpower, 1, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD);
-			MPI_Recv(&done, 1, MPI_INT, 0, 1, MPI_COMM_WORLD, &status);
+			PROF_MPI("MPI_Send", MPI_Send(&oldpower, 1, MPI_DOUBLE, 0, 1, MPI_COMM_WORLD));
+			PROF_MPI("MPI_Recv", MPI_Recv(&done, 1, MPI_INT, 0, 1, MPI_COMM_WORLD, &status));
 		}
 		// if all values are within the tolerance then end the loop
 		if (done == -1)
 			break;
 	}
+	jacobi.stop();
 
 	// output data to the console
 	if (rank == 0) 
@@ -160,6 +172,8 @@ int main(int argc, char** argv)
 		std::cout << "Jacobi's method took " << iterations << " iterations to complete with an error tolerance of "
 			<< tolerance << std::endl;
 	}
+	profFinish();
+
 	// finalize the MPI environment
 	MPI_Finalize();
 }
@@ -174,7 +188,7 @@ int isDone (double op, double tol, int size, double ps[])
 	double *oldpowers = new double[size];
 	oldpowers[0] = op;
 	for (int i = 1; i < size; i++)
-		MPI_Recv(&oldpowers[i], 1, MPI_DOUBLE, i, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+		PROF_MPI("MPI_Recv", MPI_Recv(&oldpowers[i], 1, MPI_DOUBLE, i, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
 
 	// if any value is not in tolerance return false
 	for (int x = 0; x < size; x++)
@@ -7,7 +7,12 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <iomanip>
 #include <vector>
+#include <algorithm>
+#include "../Common/Profiler.h"
+#include "../Common/TaskGraph.h"
+#include "../Common/Numa.h"
 
 #define INT_MAX 2147483647
 
@@ -18,32 +23,80 @@ struct path
 	int destination;
 };
 
+// an edge read from the graph file
+struct edge
+{
+	int start;
+	int end;
+	int distance;
+};
+
 // global variables
 int** dist;
 std::string* edgenames;
 int num_nodes;
 int **paths;
 int threads;
+// -tasks runs blocked floyd-warshall as a graph of tile tasks with no barriers
+bool useTasks = false;
+int tile = 64;
+// where the matrices live and where the threads run, -numabench times every placement
+int placement = NUMA_FIRST_TOUCH;
+std::string pinning = "none";
+bool numaBench = false;
+std::vector<edge> edges;
 
 // function prototypes
 path getUserInput();
 double floydWarshall();
+double floydWarshallTasks();
+void initPaths();
+int** allocMatrix(int, int);
+void freeMatrix(int**);
+void loadGraph();
+void numaBenchmark();
+void floydTile(int, int, int);
 void getPathRecursive(int, int);
 
 int main(int argc, char** argv)
 {
+	// read the command line options
+	for (int x = 1; x < argc; x++)
+	{
+		std::string arg = argv[x];
+		if (arg == "-tasks")
+			useTasks = true;
+		else if (arg == "-tile" && x + 1 < argc)
+			tile = std::max(atoi(argv[++x]), 1);
+		else if (arg == "-place" && x + 1 < argc)
+			placement = numaParsePlacement(argv[++x]);
+		else if (arg == "-pin" && x + 1 < argc)
+			pinning = argv[++x];
+		else if (arg == "-numabench")
+			numaBench = true;
+	}
+	if (placement < 0)
+	{
+		std::cout << "Placement must be serial, first or interleave" << std::endl;
+		return 1;
+	}
+
 	// local variables
 	std::string filename;
 	std::cout << "Enter number of threads: ";
 	std::cin >> threads;
 	std::cout << "Enter filename: ";
 	std::cin >> filename;
+	threads = std::max(threads, 1);
+	if (numaPin(pinning, threads) != 0)
+		return 1;
 
 	// open the file with the graph data
 	std::ifstream infile;
 	infile.open(filename.c_str());
 
 	// make sure the file was open successfully before reading data
+	ProfScope reading("read graph");
 	if (infile.is_open()) {
 
 		// get the number of nodes from the first line of the file
@@ -56,24 +109,7 @@ int main(int argc, char** argv)
 		for (int x = 0; x < num_nodes; x++)
 			getline(infile, edgenames[x]);
 
-		// declare a dynamic sized 2D array based on number of nodes and
-		dist = new int*[num_nodes];
-		for (int x = 0; x < num_nodes; x++)
-		{
-			dist[x] = new int[num_nodes];
-			// fill adjacency matrix with INT_MAX to start
-			for (int y = 0; y < num_nodes; y++)
-			{
-				// each nodes distance to itself is 0
-				if (x == y)
-					dist[x][y] = 0;
-				// node to other node dist all start at "infinity"
-				else
-					dist[x][y] = INT_MAX;
-			}
-		}
-
-		// read the data from the file into the adjacency matrix
+		// read the edges, the matrix is built from them so it can be placed again for the benchmark
 		int s, e, d;
 		while (!infile.eof())
 		{
@@ -87,8 +123,8 @@ int main(int argc, char** argv)
 				// -1 as start node marks the end of the file
 				if (s != -1)
 				{
-					dist[s][e] = d;
-					dist[e][s] = d;
+					edge next = { s, e, d };
+					edges.push_back(next);
 				}
 			}
 		}
@@ -101,8 +137,13 @@ int main(int argc, char** argv)
 	}
 
 	infile.close();
-	double time = floydWarshall();
+	loadGraph();
+	reading.stop();
+	if (numaBench)
+		numaBenchmark();
+	double time = useTasks ? floydWarshallTasks() : floydWarshall();
 	std::cout << "Total time on " << threads << " threads: " << time << std::endl;
+	profFinish();
 	char cont = 'y';
 	do
 	{
@@ -116,7 +157,9 @@ int main(int argc, char** argv)
 		std::cout << "Another path (y/n)? ";
 		std::cin >> cont;
 	} while (cont == 'y');
-	delete dist, paths, edgenames;
+	freeMatrix(dist);
+	freeMatrix(paths);
+	delete[] edgenames;
 	return 1;
 }
 
@@ -138,42 +181,174 @@ path getUserInput()
 	return ret;
 }
 
-double floydWarshall() {
-	int i, j, k;
-	// initialize paths array with all -1s 
-	paths = new int*[num_nodes];
+/* Allocate a num_nodes x num_nodes matrix in one block with a pointer per row. Every row is filled by the
+ * thread that owns it in the static schedule of floydWarshall(), so under first touch its pages land on
+ * that thread's node. The diagonal gets its own value.
+ */
+int** allocMatrix(int fill, int diagonal)
+{
+	if (num_nodes == 0)
+		return nullptr;
+	int* block = (int*)numaAlloc(sizeof(int) * num_nodes * num_nodes, placement);
+	int** rows = new int*[num_nodes];
+	#pragma omp parallel for schedule(static) num_threads(threads) if (placement != NUMA_SERIAL)
 	for (int x = 0; x < num_nodes; x++)
 	{
-		paths[x] = new int[num_nodes];
+		rows[x] = block + (size_t)x * num_nodes;
 		for (int y = 0; y < num_nodes; y++)
-			paths[x][y] = -1;
+			rows[x][y] = x == y ? diagonal : fill;
+	}
+	return rows;
+}
+
+void freeMatrix(int** rows)
+{
+	if (rows == nullptr)
+		return;
+	numaFree(rows[0], sizeof(int) * num_nodes * num_nodes);
+	delete[] rows;
+}
+
+/* build the adjacency matrix from the edges, each nodes distance to itself is 0 and all other distances
+ * start at "infinity"
+ */
+void loadGraph()
+{
+	dist = allocMatrix(INT_MAX, 0);
+	for (size_t x = 0; x < edges.size(); x++)
+	{
+		dist[edges[x].start][edges[x].end] = edges[x].distance;
+		dist[edges[x].end][edges[x].start] = edges[x].distance;
+	}
+}
+
+/* allocate the paths array with all -1s */
+void initPaths()
+{
+	ProfScope init("initialize paths");
+	paths = allocMatrix(-1, -1);
+}
+
+/* solve the graph once under every placement and leave the matrices as the chosen placement built them */
+void numaBenchmark()
+{
+	int chosen = placement;
+	std::cout << "placement        seconds" << std::endl;
+	for (placement = 0; placement < NUMA_PLACEMENTS; placement++)
+	{
+		freeMatrix(dist);
+		loadGraph();
+		double time = useTasks ? floydWarshallTasks() : floydWarshall();
+		std::cout << std::left << std::setw(12) << numaPlacementName(placement) << std::right << std::setw(12)
+			<< time << std::endl;
+		freeMatrix(paths);
 	}
+	placement = chosen;
+	freeMatrix(dist);
+	loadGraph();
+}
+
+double floydWarshall() {
+	int i, j, k;
+	initPaths();
 	omp_set_num_threads(threads);
-	double startTime, finishTime;
-	#pragma omp parallel
-	startTime = omp_get_wtime();
-	for (k = 0; k < num_nodes; ++k) {
-	#pragma omp for private(i, j)
-		for (i = 0; i < num_nodes; ++i) {
-			for (j = 0; j < num_nodes; ++j)
-			{
-				// ignore cities that don't have a path or are to themselves
-				if (dist[i][k] == INT_MAX || dist[k][j] == INT_MAX || i == j)
-					continue;
 
-				// check if there is a faster path 
-				int new_dist = dist[i][k] + dist[k][j];
-				if (dist[i][j] <= new_dist)
+	// time the whole run once on the main thread, every thread also records its own share
+	ProfScope total("floyd-warshall");
+	#pragma omp parallel private(k)
+	{
+		ProfScope mine("floyd-warshall thread");
+		for (k = 0; k < num_nodes; ++k) {
+		#pragma omp for private(i, j) schedule(static)
+			for (i = 0; i < num_nodes; ++i) {
+				for (j = 0; j < num_nodes; ++j)
+				{
+					// ignore cities that don't have a path or are to themselves
+					if (dist[i][k] == INT_MAX || dist[k][j] == INT_MAX || i == j)
+						continue;
+
+					// check if there is a faster path 
+					int new_dist = dist[i][k] + dist[k][j];
+					if (dist[i][j] <= new_dist)
+						continue;
+
+					// this way is faster, update the array and store the parent for the path
+					dist[i][j] = new_dist;
+					paths[i][j] = k;
+				}
+			}
+		}
+	}
+	return total.stop();
+}
+
+/* Blocked floyd-warshall with one task per tile per round. Round kb relaxes every tile through the
+ * intermediate nodes of block kb: the diagonal tile first, then its row and column, then the rest. The
+ * graph orders the tiles by what they read and write, so a tile of round kb + 1 starts as soon as the
+ * three tiles it needs are done instead of waiting for all of round kb.
+ */
+double floydWarshallTasks() {
+	initPaths();
+	int blocks = (num_nodes + tile - 1) / tile;
+
+	// the top left element names a tile in the dependency tracking
+	ProfScope building("build task graph");
+	TaskGraph graph;
+	for (int kb = 0; kb < blocks; kb++)
+	{
+		int k = kb * tile;
+		graph.add([=] { floydTile(kb, kb, kb); }, {}, { &dist[k][k] });
+		for (int b = 0; b < blocks; b++)
+		{
+			if (b == kb)
+				continue;
+			int o = b * tile;
+			graph.add([=] { floydTile(kb, kb, b); }, { &dist[k][k] }, { &dist[k][o] });
+			graph.add([=] { floydTile(kb, b, kb); }, { &dist[k][k] }, { &dist[o][k] });
+		}
+		for (int ib = 0; ib < blocks; ib++)
+			for (int jb = 0; jb < blocks; jb++)
+				if (ib != kb && jb != kb)
+					graph.add([=] { floydTile(kb, ib, jb); }, { &dist[ib * tile][k], &dist[k][jb * tile] },
+						{ &dist[ib * tile][jb * tile] });
+	}
+	building.stop();
+
+	ProfScope total("floyd-warshall");
+	graph.run(threads);
+	double time = total.stop();
+	std::cout << graph.size() << " tile tasks of " << tile << "x" << tile << ", " << graph.steals()
+		<< " stolen" << std::endl;
+	return time;
+}
+
+/* relax tile (ib, jb) through every intermediate node of block kb */
+void floydTile(int kb, int ib, int jb)
+{
+	int kEnd = std::min((kb + 1) * tile, num_nodes);
+	int iEnd = std::min((ib + 1) * tile, num_nodes);
+	int jEnd = std::min((jb + 1) * tile, num_nodes);
+	for (int k = kb * tile; k < kEnd; k++)
+		for (int i = ib * tile; i < iEnd; i++)
+		{
+			// ignore cities that don't have a path
+			int ik = dist[i][k];
+			if (ik == INT_MAX)
+				continue;
+			for (int j = jb * tile; j < jEnd; j++)
+			{
+				if (dist[k][j] == INT_MAX || i == j)
 					continue;
 
 				// this way is faster, update the array and store the parent for the path
-				dist[i][j] = new_dist;
-				paths[i][j] = k;
+				int new_dist = ik + dist[k][j];
+				if (new_dist < dist[i][j])
+				{
+					dist[i][j] = new_dist;
+					paths[i][j] = k;
+				}
 			}
 		}
-	}
-	finishTime = omp_get_wtime();
-	return finishTime - startTime;
 }
 
 void getPathRecursive(int a, int b)
@@ -5,6 +5,12 @@
 #include <vector>
 #include <omp.h>
 #include <sstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include "../Common/Profiler.h"
+#include "../Common/TaskGraph.h"
+#include "../Common/Numa.h"
 
 // definition of node struct
 struct node
@@ -17,6 +23,12 @@ struct node
 	double ax, ay;
 };
 
+// a position in the double buffered task version
+struct position
+{
+	double x, y;
+};
+
 // global constants
 const double g = 1;
 const double m = 1;
@@ -25,35 +37,103 @@ const int p = 1000;
 
 // global variables
 int n = 1000;
-node nodes[1000];
+node* nodes;
+// where the nodes live, first touch places each node with the thread that computes it
+int placement = NUMA_FIRST_TOUCH;
 
 // function prototypes
+void allocNodes(int);
 void readData();
-void compute();
+double simulate(bool, int, int);
+void compute(int);
+double computeTasks(int, int, int);
 
 int main(int argc, char ** argv) {
+	// -tasks runs the timesteps as force and position tasks per block of nodes with no barriers
+	bool useTasks = false, numaBench = false;
+	int threads = 0, block = 25;
+	std::string pinning = "none";
+	for (int x = 1; x < argc; x++)
+	{
+		std::string arg = argv[x];
+		if (arg == "-tasks")
+			useTasks = true;
+		else if (arg == "-threads" && x + 1 < argc)
+			threads = std::max(atoi(argv[++x]), 1);
+		else if (arg == "-block" && x + 1 < argc)
+			block = std::max(atoi(argv[++x]), 1);
+		else if (arg == "-place" && x + 1 < argc)
+			placement = numaParsePlacement(argv[++x]);
+		else if (arg == "-pin" && x + 1 < argc)
+			pinning = argv[++x];
+		else if (arg == "-numabench")
+			numaBench = true;
+	}
+	// without -threads the tasks run on the OpenMP default team and the barrier version keeps p threads
+	if (threads == 0)
+		threads = useTasks ? omp_get_max_threads() : p;
+	if (placement < 0)
+	{
+		std::cout << "Placement must be serial, first or interleave" << std::endl;
+		return 1;
+	}
+	if (numaPin(pinning, threads) != 0)
+		return 1;
+
+	// run the whole simulation under every placement, each from the initial positions
+	if (numaBench)
+	{
+		int chosen = placement;
+		std::cout << "placement        seconds" << std::endl;
+		for (placement = 0; placement < NUMA_PLACEMENTS; placement++)
+		{
+			allocNodes(threads);
+			readData();
+			double time = simulate(useTasks, threads, block);
+			std::cout << std::left << std::setw(12) << numaPlacementName(placement) << std::right << std::setw(12)
+				<< time << std::endl;
+			numaFree(nodes, sizeof(node) * n);
+		}
+		placement = chosen;
+	}
 
 	// read data and initialize each node in nodes
+	ProfScope reading("read data");
+	allocNodes(threads);
 	readData();
-
-	double startTime = omp_get_wtime();
+	reading.stop();
 
 	// compute node movement for 100 timesteps
-	for (int x = 0; x < 100; x++)
-		compute();
-
-	// get wall computation time
-	double endTime = omp_get_wtime();
-	double time = endTime - startTime;
+	double time = simulate(useTasks, threads, block);
 
 	// output the data for the last 20 nodes and the time taken
 	for (int x = 980; x < n; x++)
 		std::cout << "Node "<< x+1 << " position: (" << nodes[x].px << ", " << nodes[x].py << ")" << std::endl;
-	std::cout << "Operation took " << time << " seconds on " << p << " processors" << std::endl;
+	std::cout << "Operation took " << time << " seconds on " << threads << " processors" << std::endl;
+	profFinish();
+	numaFree(nodes, sizeof(node) * n);
 
 	std::cin.get();
 }
 
+/* allocate the nodes and zero them with the same static schedule compute() uses */
+void allocNodes(int threads) {
+	nodes = (node*)numaAlloc(sizeof(node) * n, placement);
+	#pragma omp parallel for schedule(static) num_threads(threads) if (placement != NUMA_SERIAL)
+	for (int i = 0; i < n; ++i)
+		nodes[i] = node();
+}
+
+/* compute node movement for 100 timesteps, returns the wall computation time */
+double simulate(bool useTasks, int threads, int block) {
+	if (useTasks)
+		return computeTasks(100, threads, block);
+	ProfScope simulating("simulate");
+	for (int x = 0; x < 100; x++)
+		compute(threads);
+	return simulating.stop();
+}
+
 /* read positions from file and initialize each nodes member variables with 0's */
 void readData() {
 	std::ifstream inFile;
@@ -79,16 +159,17 @@ void readData() {
 }
 
 /* calculate acceleration/force, velocity, and position for each node during a single timestep */
-void compute() {
+void compute(int threads) {
 	int i, j;
 	double dist;
 
-	// set number of threads
-	omp_set_num_threads(n);
+	// run on the same team that was pinned and first touched the nodes
+	omp_set_num_threads(threads);
 	// declare parallel region and set loop j to run in parallel
-	#pragma omp parallel private(j) 
+	#pragma omp parallel private(j, dist) 
 	{
-		// compute force/acceleration
+		// compute force/acceleration, each thread's time includes waiting at the barrier
+		ProfScope forces("forces");
 		#pragma omp for schedule(static)
 		for (i = 0; i < n; ++i) {
 			// reset acceleration values
@@ -111,7 +192,10 @@ void compute() {
 			nodes[i].vy += timestep * nodes[i].ay;
 		}
 
+		forces.stop();
+
 		// compute position
+		ProfScope positions("positions");
 		#pragma omp for schedule(static)
 		for (int i = 0; i < n; ++i) {
 			nodes[i].px += nodes[i].vx * timestep;
@@ -120,4 +204,87 @@ void compute() {
 	}
 	// synchronize threads after each time step
 	#pragma omp barrier
-}
\ No newline at end of file
+}
+
+/* Run every timestep as a task graph over blocks of nodes. The force task of a block reads the positions
+ * of all nodes and updates the block's velocities, the position task of the block then writes its new
+ * positions into the other buffer. Keeping two position buffers lets a block move on while the rest of
+ * the step is still reading the old positions, and the graph only holds back the forces of the next step
+ * until every block has moved.
+ */
+double computeTasks(int steps, int threads, int block) {
+	// both buffers are placed like the nodes, touched block by block in thread order
+	position* buffers[2];
+	buffers[0] = (position*)numaAlloc(sizeof(position) * n, placement);
+	buffers[1] = (position*)numaAlloc(sizeof(position) * n, placement);
+	#pragma omp parallel for schedule(static) num_threads(threads) if (placement != NUMA_SERIAL)
+	for (int i = 0; i < n; i++)
+	{
+		buffers[0][i].x = nodes[i].px;
+		buffers[0][i].y = nodes[i].py;
+		buffers[1][i].x = buffers[1][i].y = 0.0;
+	}
+	int blocks = (n + block - 1) / block;
+
+	// the first node of a block names the block in the dependency tracking
+	ProfScope building("build task graph");
+	TaskGraph graph;
+	for (int step = 0; step < steps; step++)
+	{
+		position* now = buffers[step % 2];
+		position* next = buffers[(step + 1) % 2];
+		std::vector<const void*> everything;
+		for (int b = 0; b < blocks; b++)
+			everything.push_back(&now[b * block]);
+
+		for (int b = 0; b < blocks; b++)
+		{
+			int first = b * block, last = std::min(first + block, n);
+
+			// compute force/acceleration and velocity for the block
+			graph.add([=] {
+				for (int i = first; i < last; ++i) {
+					nodes[i].ax = 0.0;
+					nodes[i].ay = 0.0;
+					for (int j = 0; j < n; ++j) {
+						if (i != j)
+						{
+							double dist = pow((now[i].x - now[j].x), 2) + pow((now[i].y - now[j].y), 2);
+							// dont compute interactions between nodes too close
+							if (dist >= 0.1)
+							{
+								nodes[i].ax -= g * m * (now[i].x - now[j].x) / pow(dist, 1.5);
+								nodes[i].ay -= g * m * (now[i].y - now[j].y) / pow(dist, 1.5);
+							}
+						}
+					}
+					nodes[i].vx += timestep * nodes[i].ax;
+					nodes[i].vy += timestep * nodes[i].ay;
+				}
+			}, everything, { &nodes[first] });
+
+			// compute position into the other buffer
+			graph.add([=] {
+				for (int i = first; i < last; ++i) {
+					next[i].x = now[i].x + nodes[i].vx * timestep;
+					next[i].y = now[i].y + nodes[i].vy * timestep;
+				}
+			}, { &nodes[first], &now[first] }, { &next[first] });
+		}
+	}
+	building.stop();
+
+	ProfScope simulating("simulate");
+	graph.run(threads);
+	double time = simulating.stop();
+
+	for (int i = 0; i < n; i++)
+	{
+		nodes[i].px = buffers[steps % 2][i].x;
+		nodes[i].py = buffers[steps % 2][i].y;
+	}
+	numaFree(buffers[0], sizeof(position) * n);
+	numaFree(buffers[1], sizeof(position) * n);
+	std::cout << graph.size() << " tasks of " << block << " nodes, " << graph.steals() << " stolen" << std::endl;
+	return time;
+}